@@ -0,0 +1,350 @@
+/*
+*	Host benchmark and regression harness for the processing pipeline.
+*
+*	Feeds a recording through the same sources the firmware uses, one
+*	FFT_N sample frame at a time, from the capture buffer through
+*	preprocessing, the FFT, the bands and equalization, fading and color
+*	mapping into a Framebuffer. It reports throughput, the time spent in
+*	each stage and the accuracy of the fixed-point transform against a
+*	double precision FFT of the same (quantized and preprocessed) input.
+*
+*	The exit status is 1 if the SNR falls below BENCH_MIN_SNR dB or a level
+*	is off by more than BENCH_MAX_LEVEL_ERROR steps, so the bench can be run
+*	as a regression check. Build and check it from the repository root with
+*
+*		make -C bench check
+*
+*	passing the configuration macros of the firmware in CONFIG, e.g.
+*	CONFIG="-DFFT_N=128 -DFFT_REAL=0", or run it on a recording with
+*
+*		bench/bench [capture.wav | capture.pcm]
+*
+*	WAV files may be 8 bit unsigned or 16 bit signed PCM, only the first
+*	channel is used. Any other file is read as raw 16 bit signed little endian
+*	mono. Samples are requantized to the ADC resolution of adc_config. Without
+*	a file a synthetic two tone signal with noise is used.
+*/
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "include/AdcConfig.h"
+#include "include/bands.h"
+#include "include/CircularBuffer.h"
+#include "include/color.h"
+#include "include/eq.h"
+#include "include/fade.h"
+#include "include/fft.h"
+#include "include/Framebuffer.h"
+#include "include/preprocess.h"
+#include "include/ws2812.h"
+
+// Regression thresholds, see main().
+#ifndef BENCH_MIN_SNR
+#define BENCH_MIN_SNR 40
+#endif
+
+#ifndef BENCH_MAX_LEVEL_ERROR
+#define BENCH_MAX_LEVEL_ERROR 3
+#endif
+
+typedef CircularBuffer<fft_sample_t, FFT_N> capture_buffer_t;
+typedef Framebuffer<FADE_CHANNELS, 1, ws2812_encoder> bench_strip_t;
+typedef std::chrono::steady_clock bench_clock;
+
+// fft_input() reads what preprocessing left in the buffer, as the
+// preprocess_stage of the firmware does.
+typedef select_type<PREPROCESS, fft_sample_t, adc_data_t>::type bench_input_t;
+
+enum bench_stage_t {
+	BENCH_CAPTURE,
+	BENCH_PREPROCESS,
+	BENCH_FFT_INPUT,
+	BENCH_FFT_EXECUTE,
+	BENCH_FFT_OUTPUT,
+	BENCH_BANDS,
+	BENCH_FADE,
+	BENCH_COLOR,
+	BENCH_STAGES
+};
+
+// The equalizer offsets are added in the pass of bands_aggregate(), so the
+// two are one stage.
+static const char *const bench_names[BENCH_STAGES] = {
+	"capture",
+	"preprocess",
+	"fft_input",
+	"fft_execute",
+	"fft_output",
+	"bands+eq",
+	"fade",
+	"color",
+};
+
+struct bench_stat_t {
+	double min = 1e30;
+	double max = 0;
+	double sum = 0;
+};
+
+static bench_stat_t bench_stats[BENCH_STAGES];
+
+template <typename F>
+static void bench_time(bench_stage_t stage, F f) {
+	bench_clock::time_point start = bench_clock::now();
+	f();
+	double ns = std::chrono::duration<double, std::nano>(
+			bench_clock::now() - start).count();
+
+	bench_stat_t& stat = bench_stats[stage];
+	if (ns < stat.min) stat.min = ns;
+	if (ns > stat.max) stat.max = ns;
+	stat.sum += ns;
+}
+
+static uint32_t le32(const uint8_t *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+/*
+*	Read a recording as 16 bit signed samples. Returns false if the file can
+*	not be read or is a WAV file in an unsupported format.
+*/
+static bool bench_load(const char *path, std::vector<int16_t>& out,
+		uint32_t& rate) {
+	FILE *f = fopen(path, "rb");
+	if (!f) return false;
+	std::vector<uint8_t> data;
+	uint8_t chunk[4096];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+		data.insert(data.end(), chunk, chunk + n);
+	}
+	fclose(f);
+
+	if (data.size() < 12 || memcmp(&data[0], "RIFF", 4)
+			|| memcmp(&data[8], "WAVE", 4)) {
+		for (size_t i = 0; i + 1 < data.size(); i += 2) {
+			out.push_back((int16_t)le16(&data[i]));
+		}
+		rate = 0;
+		return true;
+	}
+
+	uint16_t format = 0, channels = 0, bits = 0;
+	for (size_t pos = 12; pos + 8 <= data.size();) {
+		uint32_t size = le32(&data[pos + 4]);
+		const uint8_t *body = &data[pos + 8];
+		if (pos + 8 + size > data.size()) size = data.size() - pos - 8;
+
+		if (!memcmp(&data[pos], "fmt ", 4) && size >= 16) {
+			format = le16(body);
+			channels = le16(body + 2);
+			rate = le32(body + 4);
+			bits = le16(body + 14);
+		} else if (!memcmp(&data[pos], "data", 4)) {
+			if (format != 1 || !channels || (bits != 8 && bits != 16)) {
+				return false;
+			}
+			size_t frame = channels * bits / 8;
+			for (size_t i = 0; i + frame <= size; i += frame) {
+				out.push_back(bits == 8 ? (int16_t)((body[i] - 128) << 8)
+						: (int16_t)le16(body + i));
+			}
+			return true;
+		}
+		pos += 8 + size + (size & 1);
+	}
+	return false;
+}
+
+static void bench_synthesize(std::vector<int16_t>& out, size_t count) {
+	srand(1);
+	for (size_t i = 0; i < count; ++i) {
+		double t = (double)i / adc_config::fs;
+		double x = 0.45 * sin(2 * M_PI * 440 * t)
+				+ 0.2 * sin(2 * M_PI * 5250 * t)
+				+ 0.02 * (rand() / (double)RAND_MAX - 0.5);
+		out.push_back((int16_t)lrint(x * 32767));
+	}
+}
+
+// Requantize a 16 bit sample to what the ADC would have produced. An
+// oversampled sample is already Q15, with the resolution of the sum.
+static adc_data_t bench_to_adc(int16_t s) {
+	if (adc_config::oversample > 1) {
+		return (adc_data_t)(s & ~((1 << (16 - adc_config::sum_bits)) - 1));
+	}
+	if (adc_config::left_adjust) return (adc_data_t)((s >> 8) + 128);
+	return (adc_data_t)((s >> 6) + 512);
+}
+
+static void bench_reference_fft(std::vector<std::complex<double> >& x) {
+	const size_t n = x.size();
+	for (size_t i = 1, j = 0; i < n; ++i) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j) std::swap(x[i], x[j]);
+	}
+	for (size_t len = 2; len <= n; len <<= 1) {
+		std::complex<double> w = std::polar(1.0, -2 * M_PI / len);
+		for (size_t i = 0; i < n; i += len) {
+			std::complex<double> wk = 1;
+			for (size_t k = 0; k < len / 2; ++k, wk *= w) {
+				std::complex<double> t = wk * x[i + k + len / 2];
+				x[i + k + len / 2] = x[i + k] - t;
+				x[i + k] += t;
+			}
+		}
+	}
+}
+
+// The window fft_input() applies, exactly.
+static double bench_window(uint16_t n) {
+	double x = 2 * M_PI * n / FFT_N;
+	switch (FFT_WINDOW) {
+	case FFT_WINDOW_HANN:		return 0.5 - 0.5 * cos(x);
+	case FFT_WINDOW_HAMMING:	return 0.54 - 0.46 * cos(x);
+	case FFT_WINDOW_BLACKMAN_HARRIS:
+		return 0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2 * x)
+				- 0.01168 * cos(3 * x);
+	default:					return 1;
+	}
+}
+
+// Bin k of the transform left in fft_work by fft_execute(), in [-1, 1).
+static std::complex<double> bench_bin(uint16_t k) {
+	#if FFT_REAL
+	if (k == 0) return fft_work[0].re / 32768.0;
+	#endif
+	return std::complex<double>(fft_work[k].re, fft_work[k].im) / 32768.0;
+}
+
+int main(int argc, char **argv) {
+	std::vector<int16_t> pcm;
+	uint32_t rate = adc_config::fs;
+
+	if (argc > 1) {
+		if (!bench_load(argv[1], pcm, rate)) {
+			fprintf(stderr, "%s: can not read %s\n", argv[0], argv[1]);
+			return 1;
+		}
+		if (rate && rate != adc_config::fs) {
+			fprintf(stderr, "warning: recorded at %u Hz, the ADC samples at "
+					"%u Hz\n", (unsigned)rate, (unsigned)adc_config::fs);
+		}
+	} else {
+		bench_synthesize(pcm, 2000 * FFT_N);
+	}
+
+	const size_t frames = pcm.size() / FFT_N;
+	if (!frames) {
+		fprintf(stderr, "%s: fewer than %d samples\n", argv[0], FFT_N);
+		return 1;
+	}
+
+	static capture_buffer_t buf;
+	static bench_strip_t strip;
+	std::vector<adc_data_t> raw(FFT_N);
+	std::vector<std::complex<double> > ref(FFT_N);
+	double signal = 0, error = 0, max_error = 0;
+	int max_level_error = 0;
+
+	eq_load(&EQ_PRESET);
+
+	for (size_t f = 0; f < frames; ++f) {
+		const int16_t *in = &pcm[f * FFT_N];
+		for (uint16_t i = 0; i < FFT_N; ++i) raw[i] = bench_to_adc(in[i]);
+
+		bench_time(BENCH_CAPTURE, [&] {
+			buf.clear();
+			for (uint16_t i = 0; i < FFT_N; ++i) buf.write(raw[i]);
+		});
+		bench_time(BENCH_PREPROCESS, [&] {
+			#if PREPROCESS
+			preprocess_block<adc_data_t, FFT_N>(buf.data());
+			#endif
+		});
+
+		// The reference transforms the same input as fft_input().
+		for (uint16_t i = 0; i < FFT_N; ++i) {
+			ref[i] = fft_from_adc((bench_input_t)buf.data()[i]) / 32768.0
+					* bench_window(i);
+		}
+
+		bench_time(BENCH_FFT_INPUT, [&] { fft_input<bench_input_t>(buf); });
+		bench_time(BENCH_FFT_EXECUTE, [&] { fft_execute(); });
+		bench_time(BENCH_FFT_OUTPUT, [&] { fft_output(); });
+
+		// Both transforms are scaled by 1/N.
+		bench_reference_fft(ref);
+		for (uint16_t k = 0; k < FFT_BINS; ++k) {
+			std::complex<double> expect = ref[k] / (double)FFT_N;
+			double e = std::abs(bench_bin(k) - expect);
+			signal += std::norm(expect);
+			error += e * e;
+			if (e > max_error) max_error = e;
+
+			// Exact level of the fixed-point bin, which is what fft_output()
+			// approximates. Below 16 LSB (level 64) the integer magnitude of
+			// the approximate and root modes is too coarse to compare.
+			double m = std::abs(bench_bin(k)) * 32768;
+			if (m >= 16) {
+				int d = abs(fft_levels[k] - (int)(16 * log2(m)));
+				if (d > max_level_error) max_level_error = d;
+			}
+		}
+
+		// A spectrum frame per LED frame, which is the most the map sees.
+		bench_time(BENCH_BANDS, [&] { bands_aggregate(fft_levels); });
+		bench_time(BENCH_FADE, [&] {
+			fade_input(band_levels, BANDS_COUNT);
+			fade_step();
+		});
+		bench_time(BENCH_COLOR, [&] {
+			color_render(strip);
+			fade_clean();
+			strip.swap();
+		});
+	}
+
+	double total = 0;
+	printf("N %d, %s, radix %d, %u bit ADC x%u, Fs %u Hz, %zu frames\n",
+			FFT_N, FFT_REAL ? "real" : "complex", FFT_RADIX,
+			adc_config::oversample > 1 ? adc_config::sum_bits : adc_config::bits,
+			adc_config::oversample, (unsigned)adc_config::fs, frames);
+	for (int i = 0; i < BENCH_STAGES; ++i) {
+		const bench_stat_t& stat = bench_stats[i];
+		printf("%-12s min %9.0f ns  max %9.0f ns  mean %9.0f ns\n",
+				bench_names[i], stat.min, stat.max, stat.sum / frames);
+		total += stat.sum;
+	}
+	printf("throughput   %.0f frames/s (real time needs %.0f)\n",
+			frames / (total * 1e-9), (double)adc_config::fs / FFT_N);
+	double snr = 10 * log10(signal / error);
+	printf("accuracy     SNR %.1f dB, max bin error %.1f LSB\n",
+			snr, max_error * 32768);
+	printf("levels       magnitude mode %d, max error %d steps above 16 LSB\n",
+			FFT_MAGNITUDE, max_level_error);
+
+	bool pass = true;
+	if (!(snr >= BENCH_MIN_SNR)) {
+		printf("FAIL         SNR below %d dB\n", BENCH_MIN_SNR);
+		pass = false;
+	}
+	if (max_level_error > BENCH_MAX_LEVEL_ERROR) {
+		printf("FAIL         level error above %d steps\n",
+				BENCH_MAX_LEVEL_ERROR);
+		pass = false;
+	}
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+/*
+*	Cycle exact on-target benchmark under simavr.
+*
+*	Runs a firmware ELF on a simulated ATmega328P with a synthetic signal on
+*	ADC0 and reports, in CPU cycles,
+*
+*		- every ADC_vect invocation, from the first instruction of the vector
+*		  to the end of its reti (the 4 cycle interrupt response of the
+*		  hardware is not included), with no instrumentation in the ISR,
+*		- every loop() iteration and the share of it spent in the ISR,
+*		- every profiled stage of the pipeline.
+*
+*	Frames and stages are delimited by the PROFILE_SIM markers, so build the
+*	firmware with -DPROFILE_SIM=1 and otherwise the configuration to be
+*	measured. Build the harness against simavr and run it on a firmware
+*	with
+*
+*		make -C bench sim-check FIRMWARE=firmware.elf
+*
+*	or build it with make -C bench simavr and run
+*
+*		bench/simavr [-n frames] [-s skip] [-m mcu] [-f hz] [-v vector]
+*			firmware.elf
+*
+*	The first skip frames (default 2) cover setup() and the first, longer,
+*	conversion and are not counted.
+*
+*	Whatever the firmware sends on USART0 is copied to stdout. Built with
+*	-DFFT_SELFTEST=1 (and an output other than WS2812, which takes the
+*	USART), it first prints the cycles per butterfly of the C and the
+*	assembly kernel, and if their output differs it stops, which fails the
+*	run with exit status 1.
+*/
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_adc.h>
+#include <simavr/avr_uart.h>
+
+// These must match include/profile.h.
+#define PROFILE_SIM_FRAME	0x20
+#define PROFILE_SIM_END		0x40
+#define PROFILE_SIM_BEGIN	0x80
+
+// GPIOR0 in data space.
+#define SIM_MARKER_ADDR		(0x1e + 0x20)
+
+// reti, the end of every interrupt handler.
+#define SIM_RETI			0x9518
+
+// ADC_vect on the ATmega328P.
+#define SIM_ADC_VECTOR		21
+
+// Stages in the order of profile_stage_t.
+enum {
+	SIM_STAGES = 9
+};
+
+static const char *const sim_names[SIM_STAGES] = {
+	"preprocess",
+	"fft_input",
+	"fft_execute",
+	"fft_output",
+	"output",
+	"goertzel",
+	"bands",
+	"fade",
+	"color",
+};
+
+typedef struct {
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+	uint32_t count;
+} sim_stat_t;
+
+static avr_t *avr;
+static avr_irq_t *sim_adc_in;
+
+static sim_stat_t sim_isr;
+static sim_stat_t sim_frame;
+static sim_stat_t sim_load;
+static sim_stat_t sim_stages[SIM_STAGES];
+
+static uint64_t sim_stage_start[SIM_STAGES];
+static uint64_t sim_frame_start;
+static uint64_t sim_frame_isr;
+static uint32_t sim_frames;
+static uint32_t sim_skip = 2;
+
+static void sim_record(sim_stat_t *stat, uint64_t cycles) {
+	if (!stat->count || cycles < stat->min) stat->min = cycles;
+	if (cycles > stat->max) stat->max = cycles;
+	stat->sum += cycles;
+	++stat->count;
+}
+
+static void sim_print(const char *name, const sim_stat_t *stat) {
+	if (!stat->count) return;
+	printf("%-12s min %8llu  max %8llu  mean %10.1f  (%u)\n", name,
+			(unsigned long long)stat->min, (unsigned long long)stat->max,
+			(double)stat->sum / stat->count, stat->count);
+}
+
+static int sim_counting(void) {
+	return sim_frames > sim_skip;
+}
+
+/*
+*	Marker writes from PROFILE_FRAME(), PROFILE_BEGIN() and PROFILE_END().
+*	The register is otherwise unused, so it is stored as is.
+*/
+static void sim_marker(struct avr_t *avr, avr_io_addr_t addr, uint8_t v,
+		void *param) {
+	(void)param;
+	avr->data[addr] = v;
+
+	if (v == PROFILE_SIM_FRAME) {
+		if (sim_counting()) {
+			uint64_t cycles = avr->cycle - sim_frame_start;
+			sim_record(&sim_frame, cycles);
+			sim_record(&sim_load, sim_frame_isr * 1000 / cycles);
+		}
+		sim_frame_start = avr->cycle;
+		sim_frame_isr = 0;
+		++sim_frames;
+		return;
+	}
+
+	uint8_t stage = v & 0x1f;
+	if (stage >= SIM_STAGES) return;
+	if (v & PROFILE_SIM_BEGIN) {
+		sim_stage_start[stage] = avr->cycle;
+	} else if ((v & PROFILE_SIM_END) && sim_counting()) {
+		sim_record(&sim_stages[stage], avr->cycle - sim_stage_start[stage]);
+	}
+}
+
+/*
+*	Called as every conversion starts, sets the input it will sample. Two
+*	tones at the same levels as the host benchmark, centred on AREF / 2.
+*/
+static void sim_adc_trigger(struct avr_irq_t *irq, uint32_t value,
+		void *param) {
+	(void)irq;
+	(void)value;
+	(void)param;
+	double t = (double)avr->cycle / avr->frequency;
+	double x = 0.45 * sin(2 * M_PI * 440 * t)
+			+ 0.2 * sin(2 * M_PI * 5250 * t);
+	avr_raise_irq(sim_adc_in, (uint32_t)lrint(avr->aref / 2.0 * (1 + x)));
+}
+
+// A byte sent on USART0.
+static void sim_uart_out(struct avr_irq_t *irq, uint32_t value, void *param) {
+	(void)irq;
+	(void)param;
+	putchar((int)value);
+	if (value == '\n') fflush(stdout);
+}
+
+static uint16_t sim_opcode(avr_flashaddr_t pc) {
+	return avr->flash[pc] | (avr->flash[pc + 1] << 8);
+}
+
+int main(int argc, char **argv) {
+	const char *mcu = "atmega328p";
+	uint32_t frequency = 16000000;
+	uint32_t frames = 100;
+	int vector = SIM_ADC_VECTOR;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:m:f:v:")) != -1) {
+		switch (opt) {
+			case 'n': frames = strtoul(optarg, NULL, 0); break;
+			case 's': sim_skip = strtoul(optarg, NULL, 0); break;
+			case 'm': mcu = optarg; break;
+			case 'f': frequency = strtoul(optarg, NULL, 0); break;
+			case 'v': vector = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-n frames] [-s skip] [-m mcu] "
+						"[-f hz] [-v vector] firmware.elf\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind >= argc) {
+		fprintf(stderr, "%s: no firmware\n", argv[0]);
+		return 1;
+	}
+
+	elf_firmware_t firmware = {{0}};
+	if (elf_read_firmware(argv[optind], &firmware)) {
+		fprintf(stderr, "%s: can not read %s\n", argv[0], argv[optind]);
+		return 1;
+	}
+
+	avr = avr_make_mcu_by_name(mcu);
+	if (!avr) {
+		fprintf(stderr, "%s: unknown mcu %s\n", argv[0], mcu);
+		return 1;
+	}
+	avr_init(avr);
+	avr_load_firmware(avr, &firmware);
+	avr->frequency = frequency;
+	avr->vcc = avr->avcc = avr->aref = 5000;
+
+	avr_register_io_write(avr, SIM_MARKER_ADDR, sim_marker, NULL);
+	sim_adc_in = avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0);
+	avr_irq_register_notify(
+			avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_OUT_TRIGGER),
+			sim_adc_trigger, NULL);
+	avr_irq_register_notify(
+			avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+			sim_uart_out, NULL);
+
+	// avr_run() executes one instruction and then services any pending
+	// interrupt, so the vector is entered when it returns with the pc on it.
+	// The ISR can not nest, interrupts stay disabled until its reti.
+	const avr_flashaddr_t entry = vector * avr->vector_size;
+	uint64_t isr_start = 0;
+	int in_isr = 0;
+
+	while (sim_frames <= sim_skip + frames) {
+		int reti = in_isr && sim_opcode(avr->pc) == SIM_RETI;
+
+		int state = avr_run(avr);
+		if (state == cpu_Done || state == cpu_Crashed) {
+			fprintf(stderr, "%s: firmware stopped after %llu cycles\n",
+					argv[0], (unsigned long long)avr->cycle);
+			return 1;
+		}
+
+		if (reti) {
+			uint64_t cycles = avr->cycle - isr_start;
+			in_isr = 0;
+			sim_frame_isr += cycles;
+			if (sim_counting()) sim_record(&sim_isr, cycles);
+		}
+		if (!in_isr && avr->pc == entry) {
+			in_isr = 1;
+			isr_start = avr->cycle;
+		}
+	}
+
+	printf("%s at %u Hz, %u frames, cycles\n", mcu, (unsigned)frequency,
+			(unsigned)frames);
+	sim_print("isr", &sim_isr);
+	sim_print("loop", &sim_frame);
+	for (int i = 0; i < SIM_STAGES; ++i) sim_print(sim_names[i], &sim_stages[i]);
+	if (sim_load.count) {
+		printf("isr load     min %5.1f %%  max %5.1f %%  mean %5.1f %%\n",
+				sim_load.min / 10.0, sim_load.max / 10.0,
+				(double)sim_load.sum / sim_load.count / 10.0);
+	}
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+*	Compile time ADC configuration.
+*
+*	Everything that depends on the ADC prescaler is derived here from
+*	ADC_PRESCALER, so the register settings, the sample type and the sample
+*	rate assumed by the frequency mapping can not disagree. With RATE_ADAPT
+*	the prescaler changes at runtime within the range of include/rate.h,
+*	ADC_PRESCALER is where it starts.
+*
+*	REFERENCES
+*	www.openmusiclabs.com/learning/digital/atmega-adc/
+*	www.openmusiclabs.com/learning/digital/atmega-adc/in-depth/
+*
+*   | ADC Pre | ADC Clk | # of |          |          |
+*   | -scalar | F (kHz) | Bits | Fs (kHz) | Fn (kHz) |
+*   |---------|---------|------|----------|----------|
+*   |   128   |    125  |  9.6 |    9.62  |    4.81  |
+*   |    64   |    250  |  9.5 |   19.23  |    9.62  |
+*   |    32   |    500  |  9.4 |   38.46  |   19.23  |
+*   |    16   |   1000  |  8.7 |   76.92  |   38.46  |
+*   |     8   |   2000  |  7.4 |  153.85  |   76.92  |
+*   |     4   |   4000  |  5.9 |  307.69  |  153.85  |
+*   |     2   |    N/A  |  N/A |  615.38  |  307.69  |
+*/
+#ifndef ADC_CONFIG_H
+#define ADC_CONFIG_H
+
+#include <stdint.h>
+
+#include "include/traits.h"
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#ifndef ADC_PRESCALER
+#define ADC_PRESCALER 16
+#endif
+
+// Analog pins sampled in turn, ADC_PIN..ADC_PIN + ADC_CHANNELS - 1. Each
+// gets 1 / ADC_CHANNELS of the conversions.
+#ifndef ADC_CHANNELS
+#define ADC_CHANNELS 1
+#endif
+
+// Conversions summed into each sample, a power of two up to 64. The ISR adds
+// ADC_OVERSAMPLE readings and stores their sum as one Q15 sample (a boxcar
+// filter decimating by ADC_OVERSAMPLE, i.e. a first order CIC), which gains
+// half a bit of resolution per doubling as long as the input carries about
+// an LSB of noise, at 1 / ADC_OVERSAMPLE of the sample rate. E.g. at
+// prescaler 16, 4 gives ~9.7 bits at 19.2 kHz and 16 ~10.7 bits at 4.8 kHz.
+#ifndef ADC_OVERSAMPLE
+#define ADC_OVERSAMPLE 1
+#endif
+
+// Optionally define ADC_BITS to be <= 8 to use a single byte even if this
+// means discarding some information from the ADC.
+// #define ADC_BITS 8
+
+// Whole number of effective bits at a given prescaler, 0 if unsupported.
+constexpr uint8_t adc_effective_bits(uint16_t prescaler) {
+	return prescaler == 128 ? 9 :
+			prescaler == 64 ? 9 :
+			prescaler == 32 ? 9 :
+			prescaler == 16 ? 8 :
+			prescaler == 8 ? 7 :
+			prescaler == 4 ? 5 : 0;
+}
+
+// ADPS[2:0] for a given prescaler, which is 2^ADPS.
+constexpr uint8_t adc_adps(uint16_t prescaler) {
+	return prescaler <= 1 ? 0 : 1 + adc_adps(prescaler >> 1);
+}
+
+// Sample rate of each of channels channels at a given prescaler, after
+// decimation by oversample. A free running conversion takes 13 ADC clock
+// cycles.
+constexpr uint32_t adc_fs(uint16_t prescaler, uint8_t channels = ADC_CHANNELS,
+		uint8_t oversample = ADC_OVERSAMPLE) {
+	return F_CPU / prescaler / 13 / channels / oversample;
+}
+
+template <uint16_t Prescaler, uint8_t Bits = adc_effective_bits(Prescaler),
+		uint8_t Channels = ADC_CHANNELS, uint8_t Oversample = ADC_OVERSAMPLE>
+struct AdcConfig {
+	static_assert(adc_effective_bits(Prescaler) != 0,
+			"Prescaler must be one of {4, 8, 16, 32, 64, 128}.");
+	static_assert(Bits > 0 && Bits <= adc_effective_bits(Prescaler),
+			"ADC_BITS can not exceed the effective resolution.");
+	static_assert(Channels >= 1 && Channels <= 4, "ADC_CHANNELS must be 1..4.");
+	static_assert((Oversample & (Oversample - 1)) == 0 && Oversample <= 64,
+			"ADC_OVERSAMPLE must be a power of two up to 64.");
+
+	static constexpr uint16_t prescaler = Prescaler;
+	static constexpr uint8_t adps = adc_adps(Prescaler);
+	static constexpr uint8_t bits = Bits;
+	static constexpr uint8_t channels = Channels;
+	static constexpr uint8_t oversample = Oversample;
+
+	// Results of 8 bits or less are left adjusted (ADLAR) so the entire
+	// result can be read from ADCH alone. Oversampling reads all 10 bits,
+	// the noise in the low ones is what averages out.
+	static constexpr bool left_adjust = Bits <= 8 && Oversample == 1;
+
+	// Bits of a reading and of a sum of Oversample readings. A sum is
+	// stored as Q15, so the samples are int16_t just like after
+	// preprocessing, see fft_from_adc().
+	static constexpr uint8_t reading_bits = left_adjust ? 8 : 10;
+	static constexpr uint8_t sum_bits = reading_bits + static_log2(Oversample);
+	static constexpr uint16_t sum_mid = (uint16_t)Oversample << (reading_bits - 1);
+
+	// A sum of Oversample readings as a Q15 sample centered on mid-scale.
+	static constexpr int16_t sum_q15(uint16_t sum) {
+		return (int16_t)((int16_t)(sum - sum_mid) << (16 - sum_bits));
+	}
+
+	typedef typename select_type<(Oversample > 1), int16_t,
+			typename select_type<(Bits > 8), uint16_t, uint8_t>::type>::type
+			data_t;
+
+	// fs is the sample rate of each channel, which is what the frequency
+	// mapping needs.
+	static constexpr uint32_t clock = F_CPU / Prescaler;
+	static constexpr uint32_t conversions = clock / 13;
+	static constexpr uint32_t fs = adc_fs(Prescaler, Channels, Oversample);
+	static constexpr uint32_t nyquist = fs / 2;
+
+	// CPU cycles between two conversions, the budget of the capture ISR
+	// whatever the number of channels.
+	static constexpr uint16_t cycles_per_sample = 13 * Prescaler;
+};
+
+#ifdef ADC_BITS
+typedef AdcConfig<ADC_PRESCALER, ADC_BITS, ADC_CHANNELS, ADC_OVERSAMPLE>
+		adc_config;
+#else
+typedef AdcConfig<ADC_PRESCALER> adc_config;
+#endif
+
+typedef adc_config::data_t adc_data_t;
+
+#endif
@@ -1,28 +1,127 @@
 /*
 *	CircularBuffer is an implementation of a circular buffer designed
 *	specifically for embedded systems. For this reason, its design,
-*	implementation, and set of features differences from a standard 
+*	implementation, and set of features differences from a standard
 *	implementation of a circular buffer.
+*
+*	The capacity N is a template parameter, so the storage is a plain T[N]
+*	with no heap allocation, the index type is the smallest one that can hold
+*	N and, when N is a power of two, the write index wraps with a mask
+*	instead of a compare and branch. write() runs in the ADC ISR for every
+*	conversion, so this matters.
 */
-template <typename T>
+#ifndef CIRCULAR_BUFFER_H
+#define CIRCULAR_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "include/traits.h"
+
+template <typename T, size_t N>
 class CircularBuffer {
-	
+
 	public:
-		CircularBuffer(size_t capacity);
-		~CircularBuffer(void);
-		void write(T);
-		T read();
-		bool full();
-		void clear();
+		// Indices run 0..N-1, the number of elements runs 0..N.
+		typedef typename select_type<N <= 0x100, uint8_t, uint16_t>::type
+				index_t;
+		typedef typename select_type<N < 0x100, uint8_t, uint16_t>::type
+				size_type;
+
+		static const size_t capacity = N;
+
+		CircularBuffer(void) : i(0), size(0) {}
+
+		void write(const T& data) {
+			// TODO	The const ref argument type requires that the assignment operator
+			//		for type T performs the necessary copy mechanics.
+			buffer[i] = data;
+			i = next(i);
+			if (size < N) ++size;
+		}
+
+		// Remove and return the oldest element.
+		T read() {
+			T data = (*this)[0];
+			--size;
+			return data;
+		}
+
+		bool full() const { return size >= N; }
+
+		// Empty the buffer. The next N writes fill data() in order.
+		void clear() {
+			i = 0;
+			size = 0;
+		}
 
-		//T operator[](size_t index);
-		T& operator[](size_t index);
-		const T& operator[](size_t index);
+		size_type count() const { return size; }
 
+		// Elements in write order, index 0 is the oldest.
+		T& operator[](size_t index) { return buffer[wrap(i - size + index)]; }
+		const T& operator[](size_t index) const {
+			return buffer[wrap(i - size + index)];
+		}
 
+		// Underlying storage, in write order once the buffer is full. This
+		// allows the processing stages to work on the samples in place.
+		T *data() { return buffer; }
+
+		// Write index, where the next element goes.
+		index_t head() const { return i; }
+
+		/*
+		*	The n elements written before write index end, oldest first.
+		*
+		*	Unlike operator[] of the buffer itself, this does not move while
+		*	the writer (e.g. an ISR) keeps writing, so a frame that ended at a
+		*	known index can be read in place. It stays valid until N - n more
+		*	elements have been written.
+		*/
+		class View {
+			public:
+				View(const CircularBuffer& buf, index_t end, size_t n)
+						: buffer(buf.buffer), start(end - n) {}
+
+				const T& operator[](size_t index) const {
+					return buffer[wrap(start + index)];
+				}
+
+			private:
+				const T *buffer;
+				size_t start;
+		};
+
+		View view(index_t end, size_t n) const { return View(*this, end, n); }
 
 	private:
-		unsigned char buffer[BUF_SIZE]; // TODO
-		unsigned char i;
-		unsigned char capacity;
-}
\ No newline at end of file
+		static const bool pow2 = (N & (N - 1)) == 0;
+
+		// This will likely be faster than the equivalent modulo statement,
+		// which uses division which is very slow on AVR. For a power of two
+		// the branch disappears entirely.
+		static index_t next(index_t index) {
+			if (pow2) return (index + 1) & (N - 1);
+			return (size_t)index + 1 >= N ? 0 : index + 1;
+		}
+
+		// Wrap an index that is at most one capacity out of range, in either
+		// direction. Arithmetic is done in (unsigned) size_t, so an index
+		// below zero shows up as a large value.
+		static index_t wrap(size_t index) {
+			if (pow2) return index & (N - 1);
+			if (index >= (size_t)-N) return index + N;
+			if (index >= N) return index - N;
+			return index;
+		}
+
+		// Typed as T, so the storage has T's alignment and can be
+		// reinterpreted as an array of any struct of Ts (e.g. fft_complex_t).
+		// Kept as the first member so data() is the address of the buffer,
+		// which the naked ADC ISR relies on.
+		T buffer[N];
+		index_t i;
+		size_type size;
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+*	FrameQueue is a lock-free single producer, single consumer queue of K
+*	frame buffers, a generalization of ping/pong double buffering.
+*
+*	The producer (the ADC ISR) always owns exactly one buffer, back(), which
+*	it fills. Once it is full, push() publishes it and moves on to the next
+*	free buffer. The consumer (loop()) processes front() while the queue is
+*	not empty() and releases it with pop(). With K = 3, one buffer can be
+*	processed while the next is already complete and a third is being filled,
+*	so neither side waits on the other's jitter.
+*
+*	head is only written by the producer and tail only by the consumer. Both
+*	are single bytes, which AVR reads and writes atomically, so no critical
+*	sections are needed on either side.
+*
+*	If the producer fills back() while every other buffer is still queued or
+*	being processed, the frame is dropped: back() is cleared and refilled and
+*	the overrun is counted.
+*/
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <stdint.h>
+
+#include "include/hal.h"
+
+// Keep the compiler from moving buffer accesses across an index update.
+#define FRAME_QUEUE_BARRIER() HAL_BARRIER()
+
+template <typename Buffer, uint8_t K>
+class FrameQueue {
+	static_assert(K >= 2, "FrameQueue needs at least two buffers");
+
+	public:
+		FrameQueue(void) : head(0), tail(0), dropped(0) {}
+
+		// Producer side.
+
+		// The buffer being filled.
+		Buffer& back() { return frames[head]; }
+
+		// Publish back() and start filling the next free buffer. Returns false
+		// and reuses back() if there is none.
+		bool push() {
+			uint8_t next = head + 1 == K ? 0 : head + 1;
+
+			if (next == tail) {
+				++dropped;
+				frames[head].clear();
+				return false;
+			}
+
+			frames[next].clear();
+			FRAME_QUEUE_BARRIER();
+			head = next;
+			return true;
+		}
+
+		// Consumer side.
+
+		bool empty() const { return head == tail; }
+
+		// The oldest complete buffer, only valid while !empty().
+		Buffer& front() {
+			FRAME_QUEUE_BARRIER();
+			return frames[tail];
+		}
+
+		// Release front() back to the producer.
+		void pop() {
+			FRAME_QUEUE_BARRIER();
+			tail = tail + 1 == K ? 0 : tail + 1;
+		}
+
+		// Number of complete buffers waiting, including front().
+		uint8_t ready() const {
+			uint8_t h = head;
+			uint8_t t = tail;
+			return h >= t ? h - t : h + K - t;
+		}
+
+		// Frames dropped because no buffer was free. The count is two bytes
+		// and written by the ISR, so read it until two reads agree.
+		uint16_t overruns() const {
+			uint16_t n;
+			do {
+				n = dropped;
+			} while (n != dropped);
+			return n;
+		}
+
+	private:
+		Buffer frames[K];
+		volatile uint8_t head;
+		volatile uint8_t tail;
+		volatile uint16_t dropped;
+};
+
+#endif
@@ -0,0 +1,121 @@
+/*
+*	Framebuffer is a double buffered LED strip of N pixels with dirty
+*	tracking in segments of S pixels.
+*
+*	The back buffer holds G, R, B pixels and is drawn into with set(). The
+*	front buffer holds the same pixels in the wire format of the output,
+*	Encoder::bytes per pixel, produced by Encoder::encode(). swap() encodes
+*	only the segments that were drawn into since the last swap(), so a
+*	frame in which few pixels changed costs little SRAM traffic, and the
+*	front buffer can be streamed out (e.g. by an ISR) while the next frame is
+*	drawn.
+*
+*	An encoder whose identity is true has the G, R, B pixel as its wire
+*	format, so there is no front buffer: front() is the back buffer and
+*	swap() only clears the dirty segments. The frame then changes as soon as
+*	it is drawn into, so this only suits an output that is done with the
+*	frame when show() returns, like WS2812.
+*
+*	Like CircularBuffer, pixels do not move in memory to move on the strip.
+*	Logical pixel i is stored at (i + offset) mod N and scroll() only changes
+*	offset, so a movement effect only draws the pixel that enters. The
+*	output starts at start() and wraps around to cover the whole front
+*	buffer.
+*/
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "include/traits.h"
+
+// Storage of the front buffer, none for an identity encoder.
+template <uint16_t N, typename Encoder, bool Identity = Encoder::identity>
+struct framebuffer_front {
+	uint8_t *front_data(uint8_t *) { return front_buffer; }
+	const uint8_t *front_data(const uint8_t *) const { return front_buffer; }
+
+	uint8_t front_buffer[Encoder::bytes * N];
+};
+
+template <uint16_t N, typename Encoder>
+struct framebuffer_front<N, Encoder, true> {
+	static_assert(Encoder::bytes == 3, "an identity encoder is G, R, B");
+
+	uint8_t *front_data(uint8_t *back) { return back; }
+	const uint8_t *front_data(const uint8_t *back) const { return back; }
+};
+
+template <uint16_t N, uint8_t S, typename Encoder>
+class Framebuffer : private framebuffer_front<N, Encoder> {
+	static_assert(N % S == 0, "N must be a whole number of segments");
+
+	public:
+		typedef typename select_type<N <= 0x100, uint8_t, uint16_t>::type
+				index_t;
+
+		static const uint16_t pixels = N;
+		static const uint16_t segments = N / S;
+		static const uint8_t bytes = Encoder::bytes;
+
+		// Everything starts dirty, so the first swap() encodes it all.
+		Framebuffer(void) : offset(0), front_offset(0) {
+			for (uint8_t i = 0; i < sizeof(dirty); ++i) dirty[i] = 0xff;
+		}
+
+		// Set logical pixel i to the G, R, B pixel grb.
+		void set(index_t i, const uint8_t *grb) {
+			index_t p = wrap(i + offset);
+			uint8_t *dst = back + 3 * (size_t)p;
+			dst[0] = grb[0];
+			dst[1] = grb[1];
+			dst[2] = grb[2];
+			mark_segment(p / S);
+		}
+
+		// Move every pixel one place up the strip, the last one wraps to
+		// logical pixel 0, which is to be redrawn.
+		void scroll() { offset = offset ? offset - 1 : N - 1; }
+
+		// Encode the dirty segments into the front buffer. The front buffer
+		// must not be in use by the output.
+		void swap() {
+			if (Encoder::identity) {
+				for (uint8_t i = 0; i < sizeof(dirty); ++i) dirty[i] = 0;
+				front_offset = offset;
+				return;
+			}
+
+			for (uint16_t k = 0; k < segments; ++k) {
+				if (!(dirty[k >> 3] & (1 << (k & 7)))) continue;
+				dirty[k >> 3] &= ~(1 << (k & 7));
+
+				const uint8_t *src = back + 3 * (size_t)k * S;
+				uint8_t *dst = this->front_data(back) + bytes * (size_t)k * S;
+				for (uint8_t j = 0; j < S; ++j, src += 3, dst += bytes) {
+					Encoder::encode(dst, src);
+				}
+			}
+			front_offset = offset;
+		}
+
+		// Wire format of the front buffer, in memory order.
+		const uint8_t *front() const { return this->front_data(back); }
+
+		// Memory index of logical pixel 0 in front().
+		index_t start() const { return front_offset; }
+
+	private:
+		// i is at most 2N - 2.
+		static index_t wrap(size_t i) { return i >= N ? i - N : i; }
+
+		void mark_segment(uint16_t k) { dirty[k >> 3] |= 1 << (k & 7); }
+
+		uint8_t back[3 * N];
+		uint8_t dirty[(N / S + 7) / 8];
+		index_t offset;
+		index_t front_offset;
+};
+
+#endif
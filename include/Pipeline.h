@@ -0,0 +1,130 @@
+/*
+*	Pipeline composes the stages of src/visualizer.cpp at compile time.
+*
+*	Each stage is a class of static functions and every call is resolved at
+*	compile time and inlined, there are no virtual functions or function
+*	pointers. Replacing a stage (FFT by Goertzel, ISR by polled capture, one
+*	LED backend by another) is replacing a template argument, at no cost at
+*	runtime. The stages in include/stages.h are independent of the target,
+*	capture and output are implemented next to their ISRs in
+*	src/visualizer.cpp.
+*
+*	A stage provides
+*
+*	Capture		raw_t, the type of the captured samples, in_place, true if
+*				the Spectral stage may work in the buffer, channels, the
+*				number of ADC channels in a frame, init(), acquire<Pre>(),
+*				which waits for a frame, applies Pre to the new samples and
+*				returns the frame, channel(frame, c), the samples of channel
+*				c, release(), which hands the frame back once Spectral is
+*				done with it, and dropped(), the frames lost since init().
+*	Pre			input<Raw>::type, the sample type it turns Raw into, and
+*				block<Raw, N>(x, c), which processes N samples of channel c
+*				in place.
+*	Spectral	init(), process<Input>(buf, in_place), which returns true if
+*				the frame produced new levels, levels() and count().
+*	Post		init() and process(levels, n), which returns the channel
+*				levels computed from the n spectral levels and sets n to
+*				their number.
+*	Map			pixels and segment, the size of the strip, init(), input(
+*				levels, n, first), which takes n new channel levels from
+*				channel first on, and frame(strip), which draws an LED frame
+*				into the Framebuffer.
+*	Output		encoder, the Framebuffer encoder (bytes, identity and
+*				encode()), init(), due(), true when the next LED frame is to
+*				be drawn, and show(strip).
+*/
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+
+#include "include/Framebuffer.h"
+#include "include/profile.h"
+#include "include/traits.h"
+
+template <typename Capture, typename Pre, typename Spectral, typename Post,
+		typename Map, typename Output>
+class Pipeline {
+
+	public:
+		typedef Framebuffer<Map::pixels, Map::segment,
+				typename Output::encoder> strip_t;
+
+		typedef typename Pre::template input<typename Capture::raw_t>::type
+				input_t;
+
+		static strip_t strip;
+
+		#if PROFILE
+		// Frames since the last profile_report().
+		static uint8_t profile_frames;
+		#endif
+
+		static void init() {
+			Spectral::init();
+			Post::init();
+			Map::init();
+			Output::init();
+			Capture::init();
+		}
+
+		// Restart the stages that depend on the mode, see include/mode.h.
+		// Capture and output keep running, the strip keeps what the
+		// previous effect drew.
+		static void restart() {
+			Spectral::init();
+			Post::init();
+			Map::init();
+		}
+
+		// One frame of capture and processing, and an LED frame if one is
+		// due. The spectral levels are shared, so each ADC channel is taken
+		// through to the map before the next one is transformed, and its
+		// channel levels follow those of the previous one.
+		static void run() {
+			PROFILE_FRAME();
+
+			{
+				auto&& frame = Capture::template acquire<Pre>();
+				uint8_t first = 0;
+				for (uint8_t c = 0; c < Capture::channels; ++c) {
+					bool updated = Spectral::template process<input_t>(
+							Capture::channel(frame, c),
+							bool_type<Capture::in_place>());
+					if (!updated) continue;
+
+					uint8_t n = Spectral::count();
+					const uint8_t *levels = Post::process(Spectral::levels(), n);
+					Map::input(levels, n, first);
+					first += n;
+				}
+				Capture::release();
+			}
+
+			if (Output::due()) {
+				Map::frame(strip);
+				Output::show(strip);
+			}
+
+			#if PROFILE
+			if (++profile_frames == PROFILE_REPORT_FRAMES) {
+				profile_frames = 0;
+				profile_report(Capture::dropped());
+			}
+			#endif
+		}
+};
+
+template <typename Capture, typename Pre, typename Spectral, typename Post,
+		typename Map, typename Output>
+typename Pipeline<Capture, Pre, Spectral, Post, Map, Output>::strip_t
+		Pipeline<Capture, Pre, Spectral, Post, Map, Output>::strip;
+
+#if PROFILE
+template <typename Capture, typename Pre, typename Spectral, typename Post,
+		typename Map, typename Output>
+uint8_t Pipeline<Capture, Pre, Spectral, Post, Map, Output>::profile_frames;
+#endif
+
+#endif
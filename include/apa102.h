@@ -0,0 +1,71 @@
+/*
+*	APA102 output (section G of src/visualizer.cpp) on the hardware SPI,
+*	streamed by the SPI interrupt.
+*
+*	APA102 LEDs are clocked, so there is no timing to meet and the frame can
+*	be sent a byte per interrupt in the background while loop() goes on.
+*	Every pixel is sent in its wire format, a header byte with the global
+*	brightness followed by B, G, R. The pixels come from the front buffer of
+*	a Framebuffer with apa102_encoder, so only the pixels that changed are
+*	encoded, all of them are streamed.
+*
+*	Data is MOSI (PB3, digital pin 11 on an Uno) and clock SCK (PB5, 13).
+*	SS (PB2, 10) is made an output to stay master and MISO (PB4, 12) can
+*	not be used as an output.
+*/
+#ifndef APA102_H
+#define APA102_H
+
+#include <stdint.h>
+
+// Global brightness 0..31, in the header byte of every pixel.
+#ifndef APA102_BRIGHTNESS
+#define APA102_BRIGHTNESS 31
+#endif
+
+// SPI clock F_CPU / 16, a byte every 128 cycles, so the interrupt takes a
+// fraction of the CPU while streaming.
+#define APA102_SPI_DIVIDER 16
+
+struct apa102_encoder {
+	static const uint8_t bytes = 4;
+	static const bool identity = false;
+
+	static void encode(uint8_t *dst, const uint8_t *grb) {
+		dst[0] = 0xe0 | APA102_BRIGHTNESS;
+		dst[1] = grb[2];
+		dst[2] = grb[0];
+		dst[3] = grb[1];
+	}
+};
+
+/*
+*	State of the stream in src/apa102.cpp: the next byte, the start and end
+*	of the buffer it wraps around in, the bytes left, the zeros left of the
+*	start or end frame, the length of the end frame and whether a frame is
+*	being streamed.
+*/
+struct apa102_state_t {
+	const uint8_t *ptr;
+	const uint8_t *begin;
+	const uint8_t *end;
+	uint16_t left;
+	uint8_t zeros;
+	uint8_t tail;
+	volatile bool streaming;
+};
+
+// Make the SPI a master at F_CPU / APA102_SPI_DIVIDER.
+void apa102_init();
+
+// True while a frame is being streamed, its buffer must not change.
+bool apa102_busy();
+
+/*
+*	Start streaming the n pixels of 4 bytes in wire, beginning at pixel
+*	start and wrapping around, framed by the APA102 start and end frames.
+*	Returns immediately, apa102_busy() until it is done.
+*/
+void apa102_show(const uint8_t *wire, uint16_t n, uint16_t start);
+
+#endif
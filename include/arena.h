@@ -0,0 +1,80 @@
+/*
+*	Static memory arena and SRAM budget.
+*
+*	arena only holds the state of the spectral engines. The FFT and the
+*	Goertzel engine never run at the same time (see include/mode.h), so the
+*	FFT work array and levels and the Goertzel filters are members of one
+*	union and switching engines allocates nothing. The usual names
+*	(fft_cplx_work, fft_levels, goertzel_state, goertzel_levels) are
+*	references to the members, resolved by the linker with LTO.
+*
+*	The buffers of fft_selftest() (see include/fft_butterfly.h) are a third
+*	member, as the self-test is over before either engine starts. Nothing
+*	else can share: the capture buffers are written by the ADC interrupt
+*	all the time, and the APA102 front buffer is streamed by the SPI
+*	interrupt while the next frame is transformed.
+*
+*	The capture buffers, the Framebuffer, the fade and band levels and the
+*	rest are separate globals of their modules, sized at compile time as
+*	well. src/visualizer.cpp adds up the sizes of all of them, stage by
+*	stage, and checks the sum against ARENA_BUDGET with a static_assert.
+*	tools/sram_report.py lists the actual usage of a built firmware per
+*	stage.
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+
+#include "include/fft.h"
+#include "include/fft_butterfly.h"
+#include "include/goertzel.h"
+
+// SRAM of the target, an ATmega328P by default.
+#ifndef ARENA_SRAM
+#define ARENA_SRAM 2048
+#endif
+
+// Kept free for the stack and the Arduino core (millis(), and Serial's 2 x 64
+// byte ring buffers when it is used).
+#ifndef ARENA_RESERVE
+#define ARENA_RESERVE 384
+#endif
+
+#define ARENA_BUDGET (ARENA_SRAM - ARENA_RESERVE)
+
+struct arena_fft_t {
+	#if FFT_LOAD
+	fft_complex_t work[FFT_CPLX_N];
+	#endif
+	uint8_t levels[FFT_BINS];
+};
+
+struct arena_goertzel_t {
+	goertzel_band_t bands[goertzel_bands];
+	uint8_t levels[goertzel_bands];
+};
+
+#if FFT_SELFTEST
+struct arena_selftest_t {
+	fft_complex_t ref[FFT_SELFTEST_N];
+	fft_complex_t out[FFT_SELFTEST_N];
+};
+#endif
+
+struct arena_t {
+	union {
+		arena_fft_t fft;
+		arena_goertzel_t goertzel;
+		#if FFT_SELFTEST
+		arena_selftest_t selftest;
+		#endif
+	} spectral;
+};
+
+extern arena_t arena;
+
+// The reference names take a pointer each unless LTO resolves them.
+constexpr uint8_t arena_references = 3 + FFT_LOAD;
+
+#endif
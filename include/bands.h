@@ -0,0 +1,180 @@
+/*
+*	Aggregation of FFT bins into C color bands (section F.i of
+*	src/visualizer.cpp).
+*
+*	The band edges are computed at compile time from the sample rate and
+*	FFT_N, on an octave, third octave or mel scale, and stored in PROGMEM
+*	together with the reciprocal of each band's width. There is a table for
+*	every sample rate the rate controller can select (see include/rate.h),
+*	only one without it. At runtime bands_aggregate() is a single pass over
+*	fft_levels[] that sums the levels of each band and scales the sum by the
+*	reciprocal, so there is no division and no floating point on the device.
+*
+*	The levels are logarithmic, so a band's level is the mean of its bins'
+*	levels, i.e. the geometric mean of their magnitudes.
+*
+*	Bin 0 (DC) is never part of a band. Each band covers at least one bin,
+*	so bands that would be narrower than a bin at the low end are widened
+*	and push the following edges up.
+*/
+#ifndef BANDS_H
+#define BANDS_H
+
+#include <stdint.h>
+
+#include "include/AdcConfig.h"
+#include "include/fft.h"
+#include "include/hal.h"
+
+#define BANDS_OCTAVE		0
+#define BANDS_THIRD_OCTAVE	1
+#define BANDS_MEL			2
+
+#ifndef BANDS_SCALE
+#define BANDS_SCALE BANDS_MEL
+#endif
+
+// Number of bands C.
+#ifndef BANDS_COUNT
+#define BANDS_COUNT (FFT_BINS - 1 < 12 ? FFT_BINS - 1 : 12)
+#endif
+
+// Lower edge of the first band and upper edge of the last band (mel only)
+// in Hz, the upper edge by default the Nyquist frequency. Octave bands are
+// a fixed ratio apart, so there the upper edge follows from BANDS_COUNT.
+#ifndef BANDS_LOW
+#define BANDS_LOW 40
+#endif
+
+#ifdef BANDS_HIGH
+constexpr double bands_high(uint32_t) {
+	return BANDS_HIGH;
+}
+#else
+constexpr double bands_high(uint32_t fs) {
+	return fs / 2;
+}
+#endif
+
+#if BANDS_SCALE < BANDS_OCTAVE || BANDS_SCALE > BANDS_MEL
+	#error BANDS_SCALE must be one of the BANDS_* scales.
+#endif
+
+// Level of each band, on the scale of fft_levels[] plus the equalizer
+// offset (see include/eq.h), written by bands_aggregate().
+extern uint8_t band_levels[BANDS_COUNT];
+
+// Compute band_levels[] from the FFT_BINS bin levels.
+void bands_aggregate(const uint8_t *levels);
+
+/*
+*	Compile time math for the table. exp() halves its argument until the
+*	series converges quickly and squares the result back, ln() scales by
+*	powers of two into [1, 2) and uses the atanh series.
+*/
+constexpr double bands_sq(double x) {
+	return x * x;
+}
+
+constexpr double bands_exp_series(double x, uint8_t n, double term) {
+	return n > 12 ? term : term + bands_exp_series(x, n + 1, term * x / (n + 1));
+}
+
+constexpr double bands_exp(double x) {
+	return x > 0.5 || x < -0.5 ? bands_sq(bands_exp(x / 2))
+			: bands_exp_series(x, 0, 1);
+}
+
+constexpr double bands_atanh_series(double y, double y2, uint8_t n) {
+	return n > 25 ? 0 : y / n + bands_atanh_series(y * y2, y2, n + 2);
+}
+
+constexpr double bands_ln(double x) {
+	return x >= 2 ? bands_ln(x / 2) + 0.69314718056
+			: x < 1 ? bands_ln(x * 2) - 0.69314718056
+			: 2 * bands_atanh_series((x - 1) / (x + 1),
+					bands_sq((x - 1) / (x + 1)), 1);
+}
+
+constexpr double bands_mel(double f) {
+	return 1127 * bands_ln(1 + f / 700);
+}
+
+constexpr double bands_hz(double mel) {
+	return 700 * (bands_exp(mel / 1127) - 1);
+}
+
+// Frequency of edge b of BANDS_COUNT + 1 at sample rate fs.
+constexpr double bands_edge_hz(uint8_t b, uint32_t fs) {
+	return BANDS_SCALE == BANDS_OCTAVE
+			? BANDS_LOW * bands_exp(b * 0.69314718056)
+		: BANDS_SCALE == BANDS_THIRD_OCTAVE
+			? BANDS_LOW * bands_exp(b * 0.69314718056 / 3)
+		: bands_hz(bands_mel(BANDS_LOW) + b
+				* (bands_mel(bands_high(fs)) - bands_mel(BANDS_LOW))
+				/ BANDS_COUNT);
+}
+
+// Nearest bin of a frequency.
+constexpr uint16_t bands_bin(double f, uint32_t fs) {
+	return (uint16_t)(f * FFT_N / fs + 0.5);
+}
+
+constexpr uint16_t bands_max(uint16_t a, uint16_t b) {
+	return a > b ? a : b;
+}
+
+// Edges k..b, each at least one bin past the previous edge prev.
+constexpr uint16_t bands_edge_from(uint8_t b, uint8_t k, uint16_t prev,
+		uint32_t fs) {
+	return k > b ? prev : bands_edge_from(b, k + 1,
+			bands_max(bands_bin(bands_edge_hz(k, fs), fs), prev + 1), fs);
+}
+
+// First bin of band b, or one past the last band for b = BANDS_COUNT.
+constexpr uint16_t bands_edge(uint8_t b, uint32_t fs = adc_config::fs) {
+	return bands_edge_from(b, 0, 0, fs);
+}
+
+static_assert(bands_edge(BANDS_COUNT) <= FFT_BINS,
+		"BANDS_COUNT bands do not fit the bins, use fewer bands, a lower "
+		"BANDS_LOW or a larger FFT_N");
+
+struct band_t {
+	uint8_t first;
+	uint8_t width;
+	// ceil(2^15 / width), so that width equal levels average to exactly
+	// that level.
+	uint16_t reciprocal;
+};
+
+struct bands_table_t {
+	band_t band[BANDS_COUNT];
+};
+
+template <uint8_t... I>
+struct bands_seq {};
+
+template <uint8_t N, uint8_t... I>
+struct bands_make_seq : bands_make_seq<N - 1, N - 1, I...> {};
+
+template <uint8_t... I>
+struct bands_make_seq<0, I...> {
+	typedef bands_seq<I...> type;
+};
+
+constexpr band_t bands_make_band(uint8_t b, uint32_t fs) {
+	return {
+		(uint8_t)bands_edge(b, fs),
+		(uint8_t)(bands_edge(b + 1, fs) - bands_edge(b, fs)),
+		(uint16_t)((0x8000 + bands_edge(b + 1, fs) - bands_edge(b, fs) - 1)
+				/ (bands_edge(b + 1, fs) - bands_edge(b, fs))),
+	};
+}
+
+template <uint8_t... I>
+constexpr bands_table_t bands_make_table(bands_seq<I...>, uint32_t fs) {
+	return {{ bands_make_band(I, fs)... }};
+}
+
+#endif
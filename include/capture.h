@@ -0,0 +1,34 @@
+/*
+*	Capture strategy (sections A and B of src/visualizer.cpp), selected here
+*	rather than in the sketch so the modules whose buffers depend on it
+*	agree with the capture stage, see FFT_LOAD in include/fft.h.
+*
+*	CAPTURE_ISR		Free running ADC interrupt fills a queue of buffers while the
+*					previous buffer is processed.
+*	CAPTURE_POLL	Interrupts are disabled and ADIF is polled until a single
+*					buffer is full, then it is processed. There is no per
+*					sample ISR entry/exit and no second buffer, but nothing is
+*					captured while processing and every other interrupt
+*					(including millis()) is held off during capture.
+*	CAPTURE_OVERLAP	Free running ADC interrupt writes into a single ring of
+*					2 * FFT_N samples. Every CAPTURE_HOP samples a new frame
+*					of the last FFT_N samples is processed, read in place
+*					from the ring, so frames overlap and the display updates
+*					FFT_N / CAPTURE_HOP times per frame length.
+*/
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#define CAPTURE_ISR		0
+#define CAPTURE_POLL	1
+#define CAPTURE_OVERLAP	2
+
+#ifndef CAPTURE_MODE
+#define CAPTURE_MODE CAPTURE_ISR
+#endif
+
+#if CAPTURE_MODE < CAPTURE_ISR || CAPTURE_MODE > CAPTURE_OVERLAP
+	#error CAPTURE_MODE must be one of the CAPTURE_* strategies.
+#endif
+
+#endif
@@ -0,0 +1,110 @@
+/*
+*	Mapping of the output channels to LED colors (sections F.i and F.ii of
+*	src/visualizer.cpp).
+*
+*	Everything is a table lookup, there is no HSV to RGB conversion on the
+*	device. The hue of a channel is an index into a 256 entry PROGMEM palette
+*	(see tools/gen_color_tables.py), its level plus color_hue_offset plus
+*	COLOR_SPREAD per channel, and its lightness is the gamma corrected level.
+*	Scaling the palette entry by the lightness is an 8 x 8 bit multiply per
+*	component, so a pixel costs three table reads, three multiplies and
+*	three stores.
+*
+*	Pixels are three bytes in WS2812 order, G, R, B.
+*/
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <stdint.h>
+
+#include "include/fade.h"
+#include "include/hal.h"
+
+#define COLOR_PALETTE_RAINBOW	0
+#define COLOR_PALETTE_HEAT		1
+#define COLOR_PALETTE_OCEAN		2
+
+#ifndef COLOR_PALETTE
+#define COLOR_PALETTE COLOR_PALETTE_RAINBOW
+#endif
+
+#if COLOR_PALETTE < COLOR_PALETTE_RAINBOW || COLOR_PALETTE > COLOR_PALETTE_OCEAN
+	#error COLOR_PALETTE must be one of the COLOR_PALETTE_* palettes.
+#endif
+
+// Palette entries between neighbouring channels, 0 colors every channel
+// by its level alone.
+#ifndef COLOR_SPREAD
+#define COLOR_SPREAD 0
+#endif
+
+#define COLOR_BYTES 3
+
+extern const uint8_t color_gamma_table[256] PROGMEM;
+extern const uint8_t color_palette_table[256 * COLOR_BYTES] PROGMEM;
+
+// Added to every palette index, rotate it to cycle the colors.
+extern uint8_t color_hue_offset;
+
+// c * (s + 1) / 256, so a scale of 255 keeps c and 0 gives black.
+inline uint8_t color_scale(uint8_t c, uint8_t s) {
+	return (uint8_t)(((uint16_t)c * s + c) >> 8);
+}
+
+// Write the G, R, B pixel of channel ch at level to grb.
+inline void color_map(uint8_t *grb, uint8_t ch, uint8_t level) {
+	const uint8_t *entry = color_palette_table + COLOR_BYTES
+			* (uint8_t)(level + color_hue_offset + ch * COLOR_SPREAD);
+	uint8_t lightness = pgm_read_byte(&color_gamma_table[level]);
+
+	grb[0] = color_scale(pgm_read_byte(entry), lightness);
+	grb[1] = color_scale(pgm_read_byte(entry + 1), lightness);
+	grb[2] = color_scale(pgm_read_byte(entry + 2), lightness);
+}
+
+/*
+*	Draw the channels marked in fade_dirty[] into a Framebuffer of at least
+*	FADE_CHANNELS pixels. Every channel covers a run of pixels/FADE_CHANNELS
+*	pixels and the remainder is spread over the runs like the steps of a
+*	Bresenham line, so the runs differ by at most a pixel.
+*/
+template <typename Strip>
+void color_render(Strip& strip) {
+	static const uint16_t run = Strip::pixels / FADE_CHANNELS;
+	static const uint8_t extra = Strip::pixels % FADE_CHANNELS;
+
+	uint8_t grb[COLOR_BYTES];
+	uint16_t p = 0;
+	uint16_t error = 0;
+	for (uint8_t ch = 0; ch < FADE_CHANNELS; ++ch) {
+		uint16_t n = run;
+		error += extra;
+		if (error >= FADE_CHANNELS) {
+			error -= FADE_CHANNELS;
+			++n;
+		}
+
+		if (fade_changed(ch)) {
+			color_map(grb, ch, fade_levels[ch]);
+			for (uint16_t i = 0; i < n; ++i) strip.set(p + i, grb);
+		}
+		p += n;
+	}
+}
+
+// Move a Framebuffer up by a pixel and draw the loudest channel into the
+// pixel that enters.
+template <typename Strip>
+void color_scroll(Strip& strip) {
+	uint8_t loudest = 0;
+	for (uint8_t ch = 1; ch < FADE_CHANNELS; ++ch) {
+		if (fade_levels[ch] > fade_levels[loudest]) loudest = ch;
+	}
+
+	uint8_t grb[COLOR_BYTES];
+	color_map(grb, loudest, fade_levels[loudest]);
+	strip.scroll();
+	strip.set(0, grb);
+}
+
+#endif
@@ -0,0 +1,236 @@
+/*
+*	GENERATED by tools/gen_color_tables.py, do not edit by hand.
+*/
+#ifndef COLOR_TABLES_H
+#define COLOR_TABLES_H
+
+#include "include/hal.h"
+
+// (i/255)^2.2 * 255.
+const uint8_t color_gamma_table[256] PROGMEM = {
+	  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+	  1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+	  3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+	  6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+	 12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+	 20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+	 30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+	 42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+	 56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+	 73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+	 91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+	113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+	137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+	163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+	192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+	223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+// 256 G, R, B entries of the selected palette, gamma 2.2.
+#if COLOR_PALETTE == COLOR_PALETTE_RAINBOW
+// Hue wheel at full saturation
+const uint8_t color_palette_table[768] PROGMEM = {
+	  0, 255,   0,   0, 255,   0,   0, 255,   0,   1, 255,   0,
+	  1, 255,   0,   2, 255,   0,   3, 255,   0,   5, 255,   0,
+	  6, 255,   0,   8, 255,   0,  10, 255,   0,  13, 255,   0,
+	 16, 255,   0,  19, 255,   0,  22, 255,   0,  26, 255,   0,
+	 29, 255,   0,  34, 255,   0,  38, 255,   0,  43, 255,   0,
+	 48, 255,   0,  54, 255,   0,  59, 255,   0,  65, 255,   0,
+	 72, 255,   0,  79, 255,   0,  86, 255,   0,  93, 255,   0,
+	101, 255,   0, 109, 255,   0, 117, 255,   0, 126, 255,   0,
+	135, 255,   0, 145, 255,   0, 155, 255,   0, 165, 255,   0,
+	175, 255,   0, 186, 255,   0, 198, 255,   0, 209, 255,   0,
+	221, 255,   0, 234, 255,   0, 246, 255,   0, 255, 251,   0,
+	255, 238,   0, 255, 225,   0, 255, 213,   0, 255, 201,   0,
+	255, 190,   0, 255, 179,   0, 255, 168,   0, 255, 158,   0,
+	255, 148,   0, 255, 139,   0, 255, 129,   0, 255, 120,   0,
+	255, 112,   0, 255, 104,   0, 255,  96,   0, 255,  88,   0,
+	255,  81,   0, 255,  74,   0, 255,  68,   0, 255,  61,   0,
+	255,  55,   0, 255,  50,   0, 255,  45,   0, 255,  40,   0,
+	255,  35,   0, 255,  31,   0, 255,  27,   0, 255,  23,   0,
+	255,  20,   0, 255,  17,   0, 255,  14,   0, 255,  11,   0,
+	255,   9,   0, 255,   7,   0, 255,   5,   0, 255,   4,   0,
+	255,   3,   0, 255,   2,   0, 255,   1,   0, 255,   0,   0,
+	255,   0,   0, 255,   0,   0, 255,   0,   0, 255,   0,   0,
+	255,   0,   1, 255,   0,   1, 255,   0,   2, 255,   0,   3,
+	255,   0,   4, 255,   0,   6, 255,   0,   8, 255,   0,  10,
+	255,   0,  12, 255,   0,  15, 255,   0,  18, 255,   0,  21,
+	255,   0,  24, 255,   0,  28, 255,   0,  32, 255,   0,  37,
+	255,   0,  41, 255,   0,  46, 255,   0,  52, 255,   0,  57,
+	255,   0,  63, 255,   0,  70, 255,   0,  76, 255,   0,  83,
+	255,   0,  91, 255,   0,  98, 255,   0, 106, 255,   0, 115,
+	255,   0, 123, 255,   0, 132, 255,   0, 142, 255,   0, 151,
+	255,   0, 161, 255,   0, 172, 255,   0, 183, 255,   0, 194,
+	255,   0, 205, 255,   0, 217, 255,   0, 229, 255,   0, 242,
+	255,   0, 255, 242,   0, 255, 229,   0, 255, 217,   0, 255,
+	205,   0, 255, 194,   0, 255, 183,   0, 255, 172,   0, 255,
+	161,   0, 255, 151,   0, 255, 142,   0, 255, 132,   0, 255,
+	123,   0, 255, 115,   0, 255, 106,   0, 255,  98,   0, 255,
+	 91,   0, 255,  83,   0, 255,  76,   0, 255,  70,   0, 255,
+	 63,   0, 255,  57,   0, 255,  52,   0, 255,  46,   0, 255,
+	 41,   0, 255,  37,   0, 255,  32,   0, 255,  28,   0, 255,
+	 24,   0, 255,  21,   0, 255,  18,   0, 255,  15,   0, 255,
+	 12,   0, 255,  10,   0, 255,   8,   0, 255,   6,   0, 255,
+	  4,   0, 255,   3,   0, 255,   2,   0, 255,   1,   0, 255,
+	  1,   0, 255,   0,   0, 255,   0,   0, 255,   0,   0, 255,
+	  0,   0, 255,   0,   0, 255,   0,   1, 255,   0,   2, 255,
+	  0,   3, 255,   0,   4, 255,   0,   5, 255,   0,   7, 255,
+	  0,   9, 255,   0,  11, 255,   0,  14, 255,   0,  17, 255,
+	  0,  20, 255,   0,  23, 255,   0,  27, 255,   0,  31, 255,
+	  0,  35, 255,   0,  40, 255,   0,  45, 255,   0,  50, 255,
+	  0,  55, 255,   0,  61, 255,   0,  68, 255,   0,  74, 255,
+	  0,  81, 255,   0,  88, 255,   0,  96, 255,   0, 104, 255,
+	  0, 112, 255,   0, 120, 255,   0, 129, 255,   0, 139, 255,
+	  0, 148, 255,   0, 158, 255,   0, 168, 255,   0, 179, 255,
+	  0, 190, 255,   0, 201, 255,   0, 213, 255,   0, 225, 255,
+	  0, 238, 255,   0, 251, 255,   0, 255, 246,   0, 255, 234,
+	  0, 255, 221,   0, 255, 209,   0, 255, 198,   0, 255, 186,
+	  0, 255, 175,   0, 255, 165,   0, 255, 155,   0, 255, 145,
+	  0, 255, 135,   0, 255, 126,   0, 255, 117,   0, 255, 109,
+	  0, 255, 101,   0, 255,  93,   0, 255,  86,   0, 255,  79,
+	  0, 255,  72,   0, 255,  65,   0, 255,  59,   0, 255,  54,
+	  0, 255,  48,   0, 255,  43,   0, 255,  38,   0, 255,  34,
+	  0, 255,  29,   0, 255,  26,   0, 255,  22,   0, 255,  19,
+	  0, 255,  16,   0, 255,  13,   0, 255,  10,   0, 255,   8,
+	  0, 255,   6,   0, 255,   5,   0, 255,   3,   0, 255,   2,
+	  0, 255,   1,   0, 255,   1,   0, 255,   0,   0, 255,   0,
+};
+#elif COLOR_PALETTE == COLOR_PALETTE_HEAT
+// Black body, black to white and back
+const uint8_t color_palette_table[768] PROGMEM = {
+	  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   0,
+	  0,   1,   0,   0,   2,   0,   0,   3,   0,   0,   5,   0,
+	  0,   6,   0,   0,   8,   0,   0,  10,   0,   0,  13,   0,
+	  0,  16,   0,   0,  19,   0,   0,  22,   0,   0,  26,   0,
+	  0,  29,   0,   0,  34,   0,   0,  38,   0,   0,  43,   0,
+	  0,  48,   0,   0,  54,   0,   0,  59,   0,   0,  65,   0,
+	  0,  72,   0,   0,  79,   0,   0,  86,   0,   0,  93,   0,
+	  0, 101,   0,   0, 109,   0,   0, 117,   0,   0, 126,   0,
+	  0, 135,   0,   0, 145,   0,   0, 155,   0,   0, 165,   0,
+	  0, 175,   0,   0, 186,   0,   0, 198,   0,   0, 209,   0,
+	  0, 221,   0,   0, 234,   0,   0, 246,   0,   0, 255,   0,
+	  0, 255,   0,   0, 255,   0,   1, 255,   0,   2, 255,   0,
+	  3, 255,   0,   4, 255,   0,   5, 255,   0,   7, 255,   0,
+	  9, 255,   0,  11, 255,   0,  14, 255,   0,  17, 255,   0,
+	 20, 255,   0,  23, 255,   0,  27, 255,   0,  31, 255,   0,
+	 35, 255,   0,  40, 255,   0,  45, 255,   0,  50, 255,   0,
+	 55, 255,   0,  61, 255,   0,  68, 255,   0,  74, 255,   0,
+	 81, 255,   0,  88, 255,   0,  96, 255,   0, 104, 255,   0,
+	112, 255,   0, 120, 255,   0, 129, 255,   0, 139, 255,   0,
+	148, 255,   0, 158, 255,   0, 168, 255,   0, 179, 255,   0,
+	190, 255,   0, 201, 255,   0, 213, 255,   0, 225, 255,   0,
+	238, 255,   0, 251, 255,   0, 255, 255,   0, 255, 255,   0,
+	255, 255,   1, 255, 255,   1, 255, 255,   2, 255, 255,   3,
+	255, 255,   4, 255, 255,   6, 255, 255,   8, 255, 255,  10,
+	255, 255,  12, 255, 255,  15, 255, 255,  18, 255, 255,  21,
+	255, 255,  24, 255, 255,  28, 255, 255,  32, 255, 255,  37,
+	255, 255,  41, 255, 255,  46, 255, 255,  52, 255, 255,  57,
+	255, 255,  63, 255, 255,  70, 255, 255,  76, 255, 255,  83,
+	255, 255,  91, 255, 255,  98, 255, 255, 106, 255, 255, 115,
+	255, 255, 123, 255, 255, 132, 255, 255, 142, 255, 255, 151,
+	255, 255, 161, 255, 255, 172, 255, 255, 183, 255, 255, 194,
+	255, 255, 205, 255, 255, 217, 255, 255, 229, 255, 255, 242,
+	255, 255, 255, 255, 255, 242, 255, 255, 229, 255, 255, 217,
+	255, 255, 205, 255, 255, 194, 255, 255, 183, 255, 255, 172,
+	255, 255, 161, 255, 255, 151, 255, 255, 142, 255, 255, 132,
+	255, 255, 123, 255, 255, 115, 255, 255, 106, 255, 255,  98,
+	255, 255,  91, 255, 255,  83, 255, 255,  76, 255, 255,  70,
+	255, 255,  63, 255, 255,  57, 255, 255,  52, 255, 255,  46,
+	255, 255,  41, 255, 255,  37, 255, 255,  32, 255, 255,  28,
+	255, 255,  24, 255, 255,  21, 255, 255,  18, 255, 255,  15,
+	255, 255,  12, 255, 255,  10, 255, 255,   8, 255, 255,   6,
+	255, 255,   4, 255, 255,   3, 255, 255,   2, 255, 255,   1,
+	255, 255,   1, 255, 255,   0, 255, 255,   0, 251, 255,   0,
+	238, 255,   0, 225, 255,   0, 213, 255,   0, 201, 255,   0,
+	190, 255,   0, 179, 255,   0, 168, 255,   0, 158, 255,   0,
+	148, 255,   0, 139, 255,   0, 129, 255,   0, 120, 255,   0,
+	112, 255,   0, 104, 255,   0,  96, 255,   0,  88, 255,   0,
+	 81, 255,   0,  74, 255,   0,  68, 255,   0,  61, 255,   0,
+	 55, 255,   0,  50, 255,   0,  45, 255,   0,  40, 255,   0,
+	 35, 255,   0,  31, 255,   0,  27, 255,   0,  23, 255,   0,
+	 20, 255,   0,  17, 255,   0,  14, 255,   0,  11, 255,   0,
+	  9, 255,   0,   7, 255,   0,   5, 255,   0,   4, 255,   0,
+	  3, 255,   0,   2, 255,   0,   1, 255,   0,   0, 255,   0,
+	  0, 255,   0,   0, 255,   0,   0, 246,   0,   0, 234,   0,
+	  0, 221,   0,   0, 209,   0,   0, 198,   0,   0, 186,   0,
+	  0, 175,   0,   0, 165,   0,   0, 155,   0,   0, 145,   0,
+	  0, 135,   0,   0, 126,   0,   0, 117,   0,   0, 109,   0,
+	  0, 101,   0,   0,  93,   0,   0,  86,   0,   0,  79,   0,
+	  0,  72,   0,   0,  65,   0,   0,  59,   0,   0,  54,   0,
+	  0,  48,   0,   0,  43,   0,   0,  38,   0,   0,  34,   0,
+	  0,  29,   0,   0,  26,   0,   0,  22,   0,   0,  19,   0,
+	  0,  16,   0,   0,  13,   0,   0,  10,   0,   0,   8,   0,
+	  0,   6,   0,   0,   5,   0,   0,   3,   0,   0,   2,   0,
+	  0,   1,   0,   0,   1,   0,   0,   0,   0,   0,   0,   0,
+};
+#elif COLOR_PALETTE == COLOR_PALETTE_OCEAN
+// Cyan to blue and back
+const uint8_t color_palette_table[768] PROGMEM = {
+	255,   2, 128, 255,   2, 132, 255,   2, 136, 255,   2, 140,
+	255,   2, 144, 255,   2, 149, 255,   2, 153, 255,   2, 158,
+	255,   2, 162, 255,   2, 167, 255,   2, 172, 255,   2, 177,
+	255,   2, 181, 255,   2, 186, 255,   2, 191, 255,   2, 196,
+	255,   2, 202, 255,   2, 207, 255,   2, 212, 255,   2, 218,
+	255,   2, 223, 255,   2, 229, 255,   2, 234, 255,   2, 240,
+	255,   2, 246, 255,   2, 251, 253,   2, 255, 247,   2, 255,
+	241,   2, 255, 235,   2, 255, 230,   2, 255, 224,   2, 255,
+	219,   2, 255, 213,   2, 255, 208,   2, 255, 203,   2, 255,
+	197,   2, 255, 192,   2, 255, 187,   2, 255, 182,   2, 255,
+	177,   2, 255, 173,   2, 255, 168,   2, 255, 163,   2, 255,
+	159,   2, 255, 154,   2, 255, 150,   2, 255, 145,   2, 255,
+	141,   2, 255, 137,   2, 255, 133,   2, 255, 128,   2, 255,
+	124,   2, 255, 120,   2, 255, 117,   2, 255, 113,   2, 255,
+	109,   2, 255, 105,   2, 255, 102,   2, 255,  98,   2, 255,
+	 95,   2, 255,  91,   2, 255,  88,   2, 255,  85,   2, 255,
+	 81,   2, 255,  78,   2, 255,  75,   2, 255,  72,   2, 255,
+	 69,   2, 255,  66,   2, 255,  64,   2, 255,  61,   2, 255,
+	 58,   2, 255,  56,   2, 255,  53,   2, 255,  50,   2, 255,
+	 48,   2, 255,  46,   2, 255,  43,   2, 255,  41,   2, 255,
+	 39,   2, 255,  37,   2, 255,  35,   2, 255,  33,   2, 255,
+	 31,   2, 255,  29,   2, 255,  27,   2, 255,  26,   2, 255,
+	 24,   2, 255,  22,   2, 255,  21,   2, 255,  19,   2, 255,
+	 18,   2, 255,  17,   2, 255,  15,   2, 255,  14,   2, 255,
+	 13,   2, 255,  12,   2, 255,  11,   2, 255,  10,   2, 255,
+	  9,   2, 255,   8,   2, 255,   7,   2, 255,   6,   2, 255,
+	  5,   2, 255,   5,   2, 255,   4,   2, 255,   3,   2, 255,
+	  3,   2, 255,   2,   2, 255,   2,   2, 255,   2,   2, 255,
+	  2,   2, 255,   2,   2, 255,   2,   3, 255,   2,   4, 255,
+	  2,   4, 255,   2,   5, 255,   2,   5, 255,   2,   6, 255,
+	  2,   7, 255,   2,   8, 255,   2,   9, 255,   2,  10, 255,
+	  2,  11, 255,   2,  12, 255,   2,  13, 255,   2,  14, 255,
+	  2,  15, 255,   2,  14, 255,   2,  13, 255,   2,  12, 255,
+	  2,  11, 255,   2,  10, 255,   2,   9, 255,   2,   8, 255,
+	  2,   7, 255,   2,   6, 255,   2,   5, 255,   2,   5, 255,
+	  2,   4, 255,   2,   4, 255,   2,   3, 255,   2,   2, 255,
+	  2,   2, 255,   2,   2, 255,   2,   2, 255,   2,   2, 255,
+	  3,   2, 255,   3,   2, 255,   4,   2, 255,   5,   2, 255,
+	  5,   2, 255,   6,   2, 255,   7,   2, 255,   8,   2, 255,
+	  9,   2, 255,  10,   2, 255,  11,   2, 255,  12,   2, 255,
+	 13,   2, 255,  14,   2, 255,  15,   2, 255,  17,   2, 255,
+	 18,   2, 255,  19,   2, 255,  21,   2, 255,  22,   2, 255,
+	 24,   2, 255,  26,   2, 255,  27,   2, 255,  29,   2, 255,
+	 31,   2, 255,  33,   2, 255,  35,   2, 255,  37,   2, 255,
+	 39,   2, 255,  41,   2, 255,  43,   2, 255,  46,   2, 255,
+	 48,   2, 255,  50,   2, 255,  53,   2, 255,  56,   2, 255,
+	 58,   2, 255,  61,   2, 255,  64,   2, 255,  66,   2, 255,
+	 69,   2, 255,  72,   2, 255,  75,   2, 255,  78,   2, 255,
+	 81,   2, 255,  85,   2, 255,  88,   2, 255,  91,   2, 255,
+	 95,   2, 255,  98,   2, 255, 102,   2, 255, 105,   2, 255,
+	109,   2, 255, 113,   2, 255, 117,   2, 255, 120,   2, 255,
+	124,   2, 255, 128,   2, 255, 133,   2, 255, 137,   2, 255,
+	141,   2, 255, 145,   2, 255, 150,   2, 255, 154,   2, 255,
+	159,   2, 255, 163,   2, 255, 168,   2, 255, 173,   2, 255,
+	177,   2, 255, 182,   2, 255, 187,   2, 255, 192,   2, 255,
+	197,   2, 255, 203,   2, 255, 208,   2, 255, 213,   2, 255,
+	219,   2, 255, 224,   2, 255, 230,   2, 255, 235,   2, 255,
+	241,   2, 255, 247,   2, 255, 253,   2, 255, 255,   2, 251,
+	255,   2, 246, 255,   2, 240, 255,   2, 234, 255,   2, 229,
+	255,   2, 223, 255,   2, 218, 255,   2, 212, 255,   2, 207,
+	255,   2, 202, 255,   2, 196, 255,   2, 191, 255,   2, 186,
+	255,   2, 181, 255,   2, 177, 255,   2, 172, 255,   2, 167,
+	255,   2, 162, 255,   2, 158, 255,   2, 153, 255,   2, 149,
+	255,   2, 144, 255,   2, 140, 255,   2, 136, 255,   2, 132,
+};
+#endif
+
+#endif
@@ -0,0 +1,22 @@
+/*
+*	GENERATED by tools/gen_drc_table.py, do not edit by hand.
+*/
+#ifndef DRC_TABLE_H
+#define DRC_TABLE_H
+
+#include "include/hal.h"
+
+// Q12 gain for a frame envelope of i/64 of full scale, threshold -24 dBFS,
+// ratio 3:1.
+const uint16_t preprocess_drc_table[64] PROGMEM = {
+	 25844,  25844,  25844,  25844,  24044,  21033,  18816,  17104,
+	 15735,  14610,  13667,  12863,  12168,  11559,  11021,  10542,
+	 10112,   9723,   9369,   9046,   8749,   8476,   8223,   7988,
+	  7769,   7565,   7373,   7193,   7024,   6864,   6713,   6571,
+	  6435,   6306,   6184,   6067,   5956,   5850,   5748,   5650,
+	  5557,   5467,   5381,   5299,   5219,   5142,   5068,   4997,
+	  4928,   4861,   4797,   4735,   4674,   4616,   4559,   4504,
+	  4451,   4399,   4349,   4300,   4252,   4206,   4161,   4117,
+};
+
+#endif
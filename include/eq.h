@@ -0,0 +1,111 @@
+/*
+*	Equalization (section E.i of src/visualizer.cpp), a gain per band.
+*
+*	Gain curves are Q8 tables of BANDS_COUNT entries, 256 is unity. The
+*	levels are logarithmic, so multiplying a band by its gain is adding
+*	16 * log2(gain / 256) level steps to it. eq_load() converts a curve to
+*	those offsets once and bands_aggregate() adds them in the same pass that
+*	computes the bands, so equalization costs no pass of its own.
+*
+*	Curves can be swapped at runtime, either a PROGMEM preset with
+*	eq_load() or single bands with eq_set().
+*/
+#ifndef EQ_H
+#define EQ_H
+
+#include <stdint.h>
+
+#include "include/bands.h"
+
+// Number of entries of a gain curve.
+#define EQ_BANDS BANDS_COUNT
+
+// Curve loaded by setup(), one of the presets below.
+#ifndef EQ_PRESET
+#define EQ_PRESET eq_flat
+#endif
+
+struct eq_table_t {
+	uint16_t gain[EQ_BANDS];
+};
+
+// Flat, all bands at unity.
+extern const eq_table_t eq_flat PROGMEM;
+
+// Pink noise has equal power per octave, so its level per bin falls by 3 dB
+// per octave. This rises by 3 dB per octave from unity at 1 kHz so pink
+// noise shows as a flat line.
+extern const eq_table_t eq_pink PROGMEM;
+
+// Inverse of a typical electret microphone module, second order roll offs
+// below 100 Hz and above 10 kHz, limited to +12 dB.
+extern const eq_table_t eq_mic PROGMEM;
+
+// Level offset of each band, added by bands_aggregate().
+extern int8_t eq_offsets[EQ_BANDS];
+
+// Use the gain curve table in PROGMEM.
+void eq_load(const eq_table_t *table);
+
+// Set the Q8 gain of a single band.
+void eq_set(uint8_t band, uint16_t gain);
+
+/*
+*	Compile time construction of the presets from the band edges.
+*/
+
+// Geometric center of band b in Hz.
+constexpr double eq_center_hz(uint8_t b) {
+	return bands_exp((bands_ln(bands_edge(b)) + bands_ln(bands_edge(b + 1)))
+			/ 2) * adc_config::fs / FFT_N;
+}
+
+constexpr double eq_pink_gain(double f) {
+	return bands_exp(bands_ln(f / 1000) / 2);
+}
+
+// 1 / |H(f)| of a second order Butterworth high pass at fl and low pass at
+// fh, sqrt(1 + (fl / f)^4) sqrt(1 + (f / fh)^4).
+constexpr double eq_mic_gain(double f, double fl, double fh) {
+	return bands_exp((bands_ln(1 + bands_sq(bands_sq(fl / f)))
+			+ bands_ln(1 + bands_sq(bands_sq(f / fh)))) / 2);
+}
+
+// Spot checks: the lowest band against the closed form of the square of the
+// gain, and sqrt(17), +12.3 dB, an octave below fl.
+constexpr double eq_mic_gain_sq(double f, double fl, double fh) {
+	return (1 + bands_sq(bands_sq(fl / f))) * (1 + bands_sq(bands_sq(f / fh)));
+}
+
+constexpr double eq_mic_check = bands_sq(eq_mic_gain(eq_center_hz(0), 100,
+		10000)) / eq_mic_gain_sq(eq_center_hz(0), 100, 10000);
+
+static_assert(eq_mic_check > 0.999999 && eq_mic_check < 1.000001
+		&& eq_mic_gain(50, 100, 1e9) > 4.1231
+		&& eq_mic_gain(50, 100, 1e9) < 4.1232,
+		"eq_mic_gain() is not the inverse of the microphone response");
+
+constexpr uint16_t eq_q8(double gain, double limit) {
+	return (uint16_t)((gain > limit ? limit : gain) * 256 + 0.5);
+}
+
+constexpr uint16_t eq_unity(uint8_t) {
+	return 256;
+}
+
+template <uint8_t... I>
+constexpr eq_table_t eq_make_flat(bands_seq<I...>) {
+	return {{ eq_unity(I)... }};
+}
+
+template <uint8_t... I>
+constexpr eq_table_t eq_make_pink(bands_seq<I...>) {
+	return {{ eq_q8(eq_pink_gain(eq_center_hz(I)), 255)... }};
+}
+
+template <uint8_t... I>
+constexpr eq_table_t eq_make_mic(bands_seq<I...>) {
+	return {{ eq_q8(eq_mic_gain(eq_center_hz(I), 100, 10000), 4)... }};
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*
+*	Fading and peak hold of the output channels (section F.iii of
+*	src/visualizer.cpp).
+*
+*	A channel rises as soon as a spectrum frame brings a higher level
+*	(fade_input()) and otherwise decays exponentially by 1/2^FADE_SHIFT of
+*	its level per LED frame (fade_step()), so the fade is timed by the LED
+*	frame rate, independent of how often the spectrum is updated. The fade
+*	keeps a single byte per channel, the level itself, and the decay is a
+*	shift and a subtraction.
+*
+*	With FADE_PEAKS set, every channel also has a peak that is held for
+*	FADE_HOLD LED frames and then falls by FADE_FALL levels per frame until
+*	it meets the level again. This adds a byte for the peak and a byte for
+*	the hold countdown. None of the effects draws the peaks yet, so it is
+*	off by default and only of use to a Map stage that reads fade_peaks[].
+*
+*	Both functions mark the channels whose level or peak actually changed in
+*	fade_dirty[], so only those need to be mapped and redrawn. Channels that
+*	have faded out cost a compare per LED frame.
+*/
+#ifndef FADE_H
+#define FADE_H
+
+#include <stdint.h>
+
+#include "include/bands.h"
+
+// The bands of every ADC channel, one after the other.
+#ifndef FADE_CHANNELS
+#define FADE_CHANNELS (BANDS_COUNT * ADC_CHANNELS)
+#endif
+
+// Decay per LED frame, level -= level / 2^FADE_SHIFT + 1.
+#ifndef FADE_SHIFT
+#define FADE_SHIFT 3
+#endif
+
+#ifndef FADE_PEAKS
+#define FADE_PEAKS 0
+#endif
+
+// LED frames a peak is held before it falls.
+#ifndef FADE_HOLD
+#define FADE_HOLD 24
+#endif
+
+// Levels a peak falls per LED frame once the hold has run out.
+#ifndef FADE_FALL
+#define FADE_FALL 4
+#endif
+
+#define FADE_DIRTY_BYTES ((FADE_CHANNELS + 7) / 8)
+
+static_assert(FADE_CHANNELS <= 255, "channels are indexed by a byte");
+
+extern uint8_t fade_levels[FADE_CHANNELS];
+
+#if FADE_PEAKS
+extern uint8_t fade_peaks[FADE_CHANNELS];
+
+// LED frames each peak is still held, only used by fade_step().
+extern uint8_t fade_holds[FADE_CHANNELS];
+#endif
+
+// One bit per channel, set when its level or peak changed.
+extern uint8_t fade_dirty[FADE_DIRTY_BYTES];
+
+// Raise the n channels from first on to the n levels of a new spectrum
+// frame.
+void fade_input(const uint8_t *levels, uint8_t n, uint8_t first = 0);
+
+// Advance the decay and the peaks by one LED frame. Returns true if any
+// channel changed.
+bool fade_step();
+
+inline bool fade_changed(uint8_t ch) {
+	return fade_dirty[ch >> 3] & (1 << (ch & 7));
+}
+
+// Mark every channel, so all of them are drawn again.
+inline void fade_mark_all() {
+	for (uint8_t i = 0; i < FADE_DIRTY_BYTES; ++i) fade_dirty[i] = 0xff;
+}
+
+// Clear fade_dirty[] once the changed channels have been drawn.
+inline void fade_clean() {
+	for (uint8_t i = 0; i < FADE_DIRTY_BYTES; ++i) fade_dirty[i] = 0;
+}
+
+#endif
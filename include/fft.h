@@ -0,0 +1,330 @@
+/*
+*	Fixed-point FFT for AVR.
+*
+*	Data is Q15 (int16_t in [-1, 1)) and the transform is computed in place
+*	using decimation in time, so the input must be loaded in bit-reversed
+*	order. Every stage scales its output by 1/2 per radix-2 step to prevent
+*	overflow, so the result is X[k] / N.
+*
+*	Twiddle factors are read from a quarter wave sine table in PROGMEM (see
+*	include/fft_tables.h) with a stride, so the same table serves every
+*	N <= FFT_N_MAX.
+*
+*	In real mode (FFT_REAL) the N real samples are packed as N/2 complex
+*	samples, even samples in the real part and odd samples in the imaginary
+*	part, transformed with an N/2 point complex FFT and then separated into
+*	the N/2 non-negative frequency bins of the real transform by
+*	fft_real_split(). This halves both the work array and the butterflies.
+*
+*	In real mode the transform runs directly in the capture buffer: N 16 bit
+*	samples are exactly N/2 packed complex values, so the buffer that was
+*	just filled by the ADC is converted and transformed in place without
+*	copying it or allocating a second N element array.
+*
+*	A window (FFT_WINDOW) is applied while the input is loaded, see
+*	fft_input(). Its table is stored for FFT_N_MAX and read with a stride,
+*	which for a periodic window gives exactly the values for FFT_N.
+*/
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdint.h>
+
+#include "include/capture.h"
+#include "include/hal.h"
+
+// Number of points in the transform, a power of two in [8, FFT_N_MAX].
+#ifndef FFT_N
+#define FFT_N 128
+#endif
+
+// Input is real, so use an N/2 point complex transform.
+#ifndef FFT_REAL
+#define FFT_REAL 1
+#endif
+
+// Provide fft_load(), which copies a frame into fft_cplx_work instead of
+// transforming it in place. The complex transform always loads, and so
+// does CAPTURE_OVERLAP, whose frames stay in the ring while it is written.
+// fft_cplx_work only exists with it.
+#ifndef FFT_LOAD
+#define FFT_LOAD (!FFT_REAL || CAPTURE_MODE == CAPTURE_OVERLAP)
+#endif
+
+#if !FFT_REAL && !FFT_LOAD
+	#error The complex transform needs FFT_LOAD.
+#endif
+
+#if CAPTURE_MODE == CAPTURE_OVERLAP && !FFT_LOAD
+	#error CAPTURE_OVERLAP needs FFT_LOAD.
+#endif
+
+// Use the assembly butterfly kernel (src/fft_butterfly.S) for radix-2
+// stages. Only available on AVR.
+#ifndef FFT_ASM
+	#ifdef __AVR__
+		#define FFT_ASM 1
+	#else
+		#define FFT_ASM 0
+	#endif
+#endif
+
+// Butterfly radix, 2 or 4. Radix-4 needs 3 instead of 4 complex multiplies
+// per 4 points per 2 stages. If log2(N) is odd a single radix-2 stage is run
+// first. Radix-4 butterflies are only implemented in C, so radix-2 is the
+// default when the assembly kernel is available.
+#ifndef FFT_RADIX
+	#if FFT_ASM
+		#define FFT_RADIX 2
+	#else
+		#define FFT_RADIX 4
+	#endif
+#endif
+
+// Window applied to each frame before the transform. The window scales the
+// bins by its coherent gain, 0.5 for Hann, 0.54 for Hamming and 0.36 for
+// Blackman-Harris.
+#define FFT_WINDOW_RECT				0
+#define FFT_WINDOW_HANN				1
+#define FFT_WINDOW_HAMMING			2
+#define FFT_WINDOW_BLACKMAN_HARRIS	3
+
+#ifndef FFT_WINDOW
+#define FFT_WINDOW FFT_WINDOW_HANN
+#endif
+
+// How fft_output() turns a complex bin into its level.
+//	FFT_MAGNITUDE_APPROX	max + min approximation of |X|, within 2.4%
+//							using only shifts and adds.
+//	FFT_MAGNITUDE_SQUARED	log2 of |X|^2, which is twice log2 |X|, so no
+//							root is needed at all.
+//	FFT_MAGNITUDE_ISQRT		Exact integer square root of |X|^2, as a
+//							reference for the other two.
+#define FFT_MAGNITUDE_APPROX	0
+#define FFT_MAGNITUDE_SQUARED	1
+#define FFT_MAGNITUDE_ISQRT		2
+
+#ifndef FFT_MAGNITUDE
+#define FFT_MAGNITUDE FFT_MAGNITUDE_APPROX
+#endif
+
+// Largest N supported by the bit reversal table and the twiddle table
+// circle, which must match tools/gen_fft_tables.py.
+#define FFT_N_MAX 256
+#define FFT_TABLE_N 512
+
+// Bits of the mantissa used to look up the fraction of a logarithm, which
+// must match tools/gen_fft_tables.py.
+#define FFT_LOG2_BITS 6
+
+#if FFT_N == 8
+	#define FFT_LOG2N 3
+#elif FFT_N == 16
+	#define FFT_LOG2N 4
+#elif FFT_N == 32
+	#define FFT_LOG2N 5
+#elif FFT_N == 64
+	#define FFT_LOG2N 6
+#elif FFT_N == 128
+	#define FFT_LOG2N 7
+#elif FFT_N == 256
+	#define FFT_LOG2N 8
+#else
+	#error FFT_N must be one of {8, 16, 32, 64, 128, 256}.
+#endif
+
+// Size of the complex transform actually computed.
+#if FFT_REAL
+	#define FFT_CPLX_N (FFT_N / 2)
+	#define FFT_CPLX_LOG2N (FFT_LOG2N - 1)
+#else
+	#define FFT_CPLX_N FFT_N
+	#define FFT_CPLX_LOG2N FFT_LOG2N
+#endif
+
+// Number of non-negative frequency bins, 0 .. Fs/2 exclusive.
+#define FFT_BINS (FFT_N / 2)
+
+#if FFT_RADIX != 2 && FFT_RADIX != 4
+	#error FFT_RADIX must be one of {2, 4}.
+#endif
+
+#if FFT_WINDOW < FFT_WINDOW_RECT || FFT_WINDOW > FFT_WINDOW_BLACKMAN_HARRIS
+	#error FFT_WINDOW must be one of the FFT_WINDOW_* values.
+#endif
+
+#if FFT_MAGNITUDE < FFT_MAGNITUDE_APPROX || FFT_MAGNITUDE > FFT_MAGNITUDE_ISQRT
+	#error FFT_MAGNITUDE must be one of the FFT_MAGNITUDE_* values.
+#endif
+
+#if FFT_ASM && !defined(__AVR__)
+	#error FFT_ASM requires an AVR target.
+#endif
+
+typedef int16_t fft_sample_t;
+
+struct fft_complex_t {
+	fft_sample_t re;
+	fft_sample_t im;
+};
+
+// Work array the transform is computed in, set by fft_input(). In real mode
+// this is the storage of the capture buffer being processed and bin 0 holds
+// DC in the real part and Fs/2 in the imaginary part once fft_execute()
+// returns.
+extern fft_complex_t *fft_work;
+
+#if FFT_LOAD
+// Work array of fft_load(). The complex transform of N real samples needs
+// twice the storage of the capture buffer, so fft_input() uses it too in
+// complex mode. Stored in the arena, see include/arena.h.
+extern fft_complex_t (&fft_cplx_work)[FFT_CPLX_N];
+#endif
+
+#if FFT_WINDOW != FFT_WINDOW_RECT
+// First half of the window of length FFT_N_MAX, see include/fft_tables.h.
+extern const int16_t fft_window_table[FFT_N_MAX / 2 + 1] PROGMEM;
+#endif
+
+// Level of each of the non-negative frequency bins, written by fft_output().
+// This is 16 * log2 |X[k]| with |X[k]| in LSB of Q15, 0 for |X[k]| < 1, so
+// steps are 0.38 dB, every 16 steps are an octave (6 dB) and a full scale
+// bin is 240. Stored in the arena, see include/arena.h.
+extern uint8_t (&fft_levels)[FFT_BINS];
+
+// Index of i after reversing its low log2n bits, log2n <= 8.
+uint8_t fft_bit_reverse_index(uint8_t i, uint8_t log2n);
+
+// Forward transform of bit-reversed x[0..2^log2n) in place.
+void fft_radix2(fft_complex_t *x, uint8_t log2n);
+void fft_radix4(fft_complex_t *x, uint8_t log2n);
+
+// Turn the 2^log2m point transform of packed real input into bins
+// 0..2^log2m-1 of the 2^(log2m+1) point real transform in place.
+void fft_real_split(fft_complex_t *z, uint8_t log2m);
+
+/*
+*	Convert a raw ADC reading to a Q15 sample centered on mid-scale.
+*
+*	Results of 8 bits or less are left adjusted in ADCH and are treated as Q7,
+*	10 bit results are right adjusted in ADC, see init_analog().
+*/
+inline fft_sample_t fft_from_adc(uint8_t s) {
+	return (fft_sample_t)(((int16_t)s - 128) << 8);
+}
+
+inline fft_sample_t fft_from_adc(uint16_t s) {
+	return (fft_sample_t)(((int16_t)s - 512) << 6);
+}
+
+// Samples that are already Q15, e.g. after preprocess_block().
+inline fft_sample_t fft_from_adc(int16_t s) {
+	return s;
+}
+
+// Multiply sample n of the frame by the window. The table holds the first
+// half, the second half mirrors it around FFT_N / 2.
+inline fft_sample_t fft_window(fft_sample_t s, uint16_t n) {
+	#if FFT_WINDOW == FFT_WINDOW_RECT
+	(void)n;
+	return s;
+	#else
+	uint16_t k = n <= FFT_N / 2 ? n : FFT_N - n;
+	int16_t w = pgm_read_word(&fft_window_table[k * (FFT_N_MAX / FFT_N)]);
+	return (fft_sample_t)(((int32_t)s * w) >> 15);
+	#endif
+}
+
+// Convert a packed complex value of two raw ADC readings to half scale Q15
+// in place, windowed as samples 2n and 2n + 1 of the frame. Halving keeps
+// the magnitude of every complex input below 1, fft_real_split() gives the
+// factor back.
+template <typename Raw>
+inline void fft_from_adc_packed(fft_complex_t& x, uint16_t n) {
+	x.re = fft_window(fft_from_adc((Raw)x.re), 2 * n) >> 1;
+	x.im = fft_window(fft_from_adc((Raw)x.im), 2 * n + 1) >> 1;
+}
+
+/*
+*	Prepare FFT_N samples of type Raw for fft_execute() without modifying
+*	them, reading buf[0..FFT_N) into fft_cplx_work instead. buf can be
+*	anything with operator[], e.g. a CircularBuffer::View of a frame in a
+*	ring that is still being written.
+*
+*	Each sample is converted, windowed and stored at its bit-reversed
+*	position as it is read, so this is a single pass too.
+*/
+#if FFT_LOAD
+template <typename Raw, typename Buffer>
+void fft_load(const Buffer& buf) {
+	fft_work = fft_cplx_work;
+
+	for (uint16_t i = 0; i < FFT_CPLX_N; ++i) {
+		fft_complex_t& x = fft_work[fft_bit_reverse_index(i, FFT_CPLX_LOG2N)];
+		#if FFT_REAL
+		x.re = fft_window(fft_from_adc((Raw)buf[2 * i]), 2 * i) >> 1;
+		x.im = fft_window(fft_from_adc((Raw)buf[2 * i + 1]), 2 * i + 1) >> 1;
+		#else
+		x.re = fft_window(fft_from_adc((Raw)buf[i]), i);
+		x.im = 0;
+		#endif
+	}
+}
+#endif
+
+/*
+*	Prepare a full buffer of raw ADC readings of type Raw for fft_execute().
+*
+*	In real mode the buffer's storage becomes the work array. Conversion to
+*	Q15 and the window are fused with the in-place bit reversal, so every
+*	sample is touched once: each swapped pair and each fixed point is
+*	converted and windowed by its position in the frame as it is visited.
+*
+*	Otherwise the samples are copied by fft_load().
+*/
+template <typename Raw, typename Buffer>
+void fft_input(Buffer& buf) {
+	#if FFT_REAL
+	static_assert(sizeof(*buf.data()) == sizeof(fft_sample_t),
+			"capture buffer must store fft_sample_t to be used in place");
+	fft_work = reinterpret_cast<fft_complex_t *>(buf.data());
+
+	for (uint16_t i = 0; i < FFT_CPLX_N; ++i) {
+		uint8_t j = fft_bit_reverse_index(i, FFT_CPLX_LOG2N);
+		if (i < j) {
+			fft_complex_t tmp = fft_work[j];
+			fft_work[j] = fft_work[i];
+			fft_work[i] = tmp;
+			fft_from_adc_packed<Raw>(fft_work[i], j);
+			fft_from_adc_packed<Raw>(fft_work[j], i);
+		} else if (i == j) {
+			fft_from_adc_packed<Raw>(fft_work[i], i);
+		}
+	}
+	#else
+	fft_load<Raw>(buf);
+	#endif
+}
+
+// Center frequency in Hz of bin k of an FFT_N point transform at sample
+// rate fs, e.g. fft_bin_frequency(k, adc_config::fs).
+constexpr uint32_t fft_bin_frequency(uint16_t k, uint32_t fs) {
+	return (uint32_t)k * fs / FFT_N;
+}
+
+// Transform the work array using the configured FFT_RADIX, followed by
+// fft_real_split() in real mode.
+void fft_execute();
+
+// log2(x) in Q8, 0 for x = 0, from the position of the leading one and
+// fft_log2_table.
+uint16_t fft_log2(uint32_t x);
+
+// Integer part of sqrt(x).
+uint16_t fft_isqrt(uint32_t x);
+
+// Compute the level of each bin of the transformed work array using the
+// configured FFT_MAGNITUDE.
+void fft_output();
+
+#endif
@@ -0,0 +1,72 @@
+/*
+*	Radix-2 butterfly kernel.
+*
+*	Runs count butterflies that share the twiddle factor c - j*s:
+*
+*		a = x[2*h*i], b = x[2*h*i + h],	i = 0..count-1
+*		t = (c - j*s) * b
+*		a, b = a/2 + t/2, a/2 - t/2
+*
+*	which is one group of one stage of fft_radix2(). There are two versions
+*	with identical output: a C reference and a hand-scheduled AVR assembly
+*	version (src/fft_butterfly.S). FFT_ASM selects which one the FFT uses,
+*	both are always linked on AVR so they can be compared.
+*
+*	With FFT_SELFTEST set, setup() first runs both on the same pseudo-random
+*	butterflies with fft_selftest(), which reports the cycles each took
+*	over Serial and stops the firmware if their output differs in a single
+*	bit. Under bench/simavr the report shows on stdout and a stopped
+*	firmware fails the run.
+*/
+#ifndef FFT_BUTTERFLY_H
+#define FFT_BUTTERFLY_H
+
+#include <stdint.h>
+
+#include "include/fft.h"
+
+#ifndef FFT_SELFTEST
+#define FFT_SELFTEST 0
+#endif
+
+#if FFT_SELFTEST && !defined(__AVR__)
+#error FFT_SELFTEST compares against the AVR assembly kernel
+#endif
+
+// Complex samples per run, enough for 16 butterflies at h = 1 or 8 at h = 2.
+#define FFT_SELFTEST_N 32
+
+// Serial rate of the fft_selftest() report.
+#ifndef FFT_SELFTEST_BAUD
+#define FFT_SELFTEST_BAUD 115200
+#endif
+
+extern "C" {
+
+void fft_butterflies_c(fft_complex_t *x, uint16_t h, uint16_t count,
+		int16_t c, int16_t s);
+
+#ifdef __AVR__
+void fft_butterflies_asm(fft_complex_t *x, uint16_t h, uint16_t count,
+		int16_t c, int16_t s);
+#endif
+
+}
+
+inline void fft_butterflies(fft_complex_t *x, uint16_t h, uint16_t count,
+		int16_t c, int16_t s) {
+	#if FFT_ASM
+	fft_butterflies_asm(x, h, count, c, s);
+	#else
+	fft_butterflies_c(x, h, count, c, s);
+	#endif
+}
+
+#if FFT_SELFTEST
+// Run both kernels on the same input, print the cycles of each and whether
+// they match. Returns true if the output is bit-identical. Uses Timer1 and
+// Serial and restores both.
+bool fft_selftest();
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+/*
+*	GENERATED by tools/gen_fft_tables.py, do not edit by hand.
+*/
+#ifndef FFT_TABLES_H
+#define FFT_TABLES_H
+
+#include "include/hal.h"
+
+// Quarter wave of sin(2*pi*k/512) in Q15, k = 0..128.
+const int16_t fft_sin_table[129] PROGMEM = {
+	     0,    402,    804,   1206,   1608,   2009,   2411,   2811,
+	  3212,   3612,   4011,   4410,   4808,   5205,   5602,   5998,
+	  6393,   6787,   7180,   7571,   7962,   8351,   8740,   9127,
+	  9512,   9896,  10279,  10660,  11039,  11417,  11793,  12167,
+	 12540,  12910,  13279,  13646,  14010,  14373,  14733,  15091,
+	 15447,  15800,  16151,  16500,  16846,  17190,  17531,  17869,
+	 18205,  18538,  18868,  19195,  19520,  19841,  20160,  20475,
+	 20788,  21097,  21403,  21706,  22006,  22302,  22595,  22884,
+	 23170,  23453,  23732,  24008,  24279,  24548,  24812,  25073,
+	 25330,  25583,  25833,  26078,  26320,  26557,  26791,  27020,
+	 27246,  27467,  27684,  27897,  28106,  28311,  28511,  28707,
+	 28899,  29086,  29269,  29448,  29622,  29792,  29957,  30118,
+	 30274,  30425,  30572,  30715,  30853,  30986,  31114,  31238,
+	 31357,  31471,  31581,  31686,  31786,  31881,  31972,  32058,
+	 32138,  32214,  32286,  32352,  32413,  32470,  32522,  32568,
+	 32610,  32647,  32679,  32706,  32729,  32746,  32758,  32766,
+	 32767,
+};
+
+// 8-bit bit reversal, right shift by (8 - log2(N)) for smaller N.
+const uint8_t fft_bitrev_table[256] PROGMEM = {
+	  0, 128,  64, 192,  32, 160,  96, 224,  16, 144,  80, 208,  48, 176, 112, 240,
+	  8, 136,  72, 200,  40, 168, 104, 232,  24, 152,  88, 216,  56, 184, 120, 248,
+	  4, 132,  68, 196,  36, 164, 100, 228,  20, 148,  84, 212,  52, 180, 116, 244,
+	 12, 140,  76, 204,  44, 172, 108, 236,  28, 156,  92, 220,  60, 188, 124, 252,
+	  2, 130,  66, 194,  34, 162,  98, 226,  18, 146,  82, 210,  50, 178, 114, 242,
+	 10, 138,  74, 202,  42, 170, 106, 234,  26, 154,  90, 218,  58, 186, 122, 250,
+	  6, 134,  70, 198,  38, 166, 102, 230,  22, 150,  86, 214,  54, 182, 118, 246,
+	 14, 142,  78, 206,  46, 174, 110, 238,  30, 158,  94, 222,  62, 190, 126, 254,
+	  1, 129,  65, 193,  33, 161,  97, 225,  17, 145,  81, 209,  49, 177, 113, 241,
+	  9, 137,  73, 201,  41, 169, 105, 233,  25, 153,  89, 217,  57, 185, 121, 249,
+	  5, 133,  69, 197,  37, 165, 101, 229,  21, 149,  85, 213,  53, 181, 117, 245,
+	 13, 141,  77, 205,  45, 173, 109, 237,  29, 157,  93, 221,  61, 189, 125, 253,
+	  3, 131,  67, 195,  35, 163,  99, 227,  19, 147,  83, 211,  51, 179, 115, 243,
+	 11, 139,  75, 203,  43, 171, 107, 235,  27, 155,  91, 219,  59, 187, 123, 251,
+	  7, 135,  71, 199,  39, 167, 103, 231,  23, 151,  87, 215,  55, 183, 119, 247,
+	 15, 143,  79, 207,  47, 175, 111, 239,  31, 159,  95, 223,  63, 191, 127, 255,
+};
+
+// log2(1 + i/64) in Q8, the fraction of a logarithm by the 6 bits
+// following the leading one.
+const uint8_t fft_log2_table[64] PROGMEM = {
+	  0,   5,  11,  16,  22,  27,  33,  38,  43,  48,  53,  58,  63,  68,  73,  77,
+	 82,  87,  91,  96, 100, 104, 109, 113, 117, 121, 125, 129, 134, 138, 141, 145,
+	149, 153, 157, 161, 164, 168, 172, 175, 179, 182, 186, 189, 193, 196, 200, 203,
+	206, 209, 213, 216, 219, 222, 225, 229, 232, 235, 238, 241, 244, 247, 250, 253,
+};
+
+// First half of the selected periodic window of length 256 in Q15,
+// n = 0..128, the second half is symmetric.
+#if FFT_WINDOW == FFT_WINDOW_HANN
+// Hann
+const int16_t fft_window_table[129] PROGMEM = {
+	     0,      5,     20,     44,     79,    123,    177,    241,
+	   315,    398,    491,    593,    705,    827,    958,   1098,
+	  1247,   1406,   1573,   1749,   1935,   2128,   2331,   2542,
+	  2761,   2989,   3224,   3468,   3719,   3978,   4244,   4518,
+	  4799,   5087,   5381,   5682,   5990,   6304,   6624,   6950,
+	  7282,   7619,   7961,   8308,   8661,   9018,   9379,   9745,
+	 10114,  10487,  10864,  11245,  11628,  12014,  12403,  12794,
+	 13188,  13583,  13980,  14378,  14778,  15179,  15580,  15982,
+	 16384,  16786,  17188,  17589,  17990,  18390,  18788,  19185,
+	 19580,  19974,  20365,  20754,  21140,  21523,  21904,  22281,
+	 22654,  23023,  23389,  23750,  24107,  24460,  24807,  25149,
+	 25486,  25818,  26144,  26464,  26778,  27086,  27387,  27681,
+	 27969,  28250,  28524,  28790,  29049,  29300,  29544,  29779,
+	 30007,  30226,  30437,  30640,  30833,  31019,  31195,  31362,
+	 31521,  31670,  31810,  31941,  32063,  32175,  32277,  32370,
+	 32453,  32527,  32591,  32645,  32689,  32724,  32748,  32763,
+	 32767,
+};
+#elif FFT_WINDOW == FFT_WINDOW_HAMMING
+// Hamming
+const int16_t fft_window_table[129] PROGMEM = {
+	  2621,   2626,   2640,   2662,   2694,   2735,   2785,   2843,
+	  2911,   2988,   3073,   3167,   3270,   3382,   3503,   3631,
+	  3769,   3915,   4069,   4231,   4401,   4580,   4766,   4960,
+	  5162,   5371,   5588,   5812,   6043,   6281,   6526,   6778,
+	  7036,   7301,   7572,   7849,   8132,   8421,   8716,   9015,
+	  9320,   9631,   9946,  10265,  10589,  10918,  11250,  11586,
+	 11926,  12270,  12617,  12967,  13319,  13674,  14032,  14392,
+	 14754,  15118,  15483,  15850,  16217,  16586,  16955,  17325,
+	 17695,  18065,  18434,  18804,  19172,  19540,  19906,  20272,
+	 20635,  20997,  21357,  21715,  22070,  22423,  22773,  23120,
+	 23463,  23803,  24139,  24472,  24800,  25124,  25444,  25759,
+	 26069,  26374,  26674,  26968,  27257,  27540,  27817,  28088,
+	 28353,  28611,  28863,  29108,  29347,  29578,  29802,  30018,
+	 30228,  30429,  30624,  30810,  30988,  31159,  31321,  31475,
+	 31621,  31758,  31887,  32007,  32119,  32222,  32316,  32402,
+	 32478,  32546,  32605,  32655,  32695,  32727,  32750,  32763,
+	 32767,
+};
+#elif FFT_WINDOW == FFT_WINDOW_BLACKMAN_HARRIS
+// 4 term Blackman-Harris
+const int16_t fft_window_table[129] PROGMEM = {
+	     2,      2,      3,      5,      7,      9,     13,     17,
+	    22,     27,     34,     42,     51,     61,     72,     85,
+	   100,    117,    135,    156,    179,    205,    233,    264,
+	   298,    336,    377,    422,    471,    524,    582,    645,
+	   712,    785,    864,    949,   1039,   1137,   1241,   1352,
+	  1470,   1596,   1730,   1872,   2022,   2181,   2349,   2526,
+	  2713,   2909,   3115,   3331,   3557,   3794,   4042,   4300,
+	  4570,   4850,   5141,   5444,   5758,   6083,   6419,   6767,
+	  7126,   7496,   7877,   8269,   8672,   9086,   9509,   9943,
+	 10387,  10841,  11303,  11775,  12255,  12743,  13239,  13742,
+	 14251,  14767,  15288,  15815,  16345,  16879,  17417,  17956,
+	 18498,  19040,  19583,  20125,  20665,  21204,  21739,  22271,
+	 22799,  23321,  23837,  24346,  24847,  25339,  25822,  26295,
+	 26756,  27206,  27643,  28067,  28476,  28871,  29250,  29612,
+	 29958,  30286,  30596,  30887,  31159,  31411,  31643,  31854,
+	 32044,  32212,  32359,  32483,  32586,  32665,  32722,  32757,
+	 32767,
+};
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+/*
+*	Goertzel filter bank, a sparse alternative to the FFT.
+*
+*	When the visualization only needs a handful of bands, running one
+*	Goertzel filter per band center is cheaper in memory than a full
+*	transform: there are no twiddle or bit reversal tables and no work
+*	array, just two 32 bit states and a 32 bit coefficient per band.
+*
+*	The filters are updated one sample at a time and keep running across
+*	captured frames, so the analysis length GOERTZEL_N, and with it the
+*	resolution, is 2^GOERTZEL_LOG2_BLOCKS captured frames. This is
+*	independent of the capture buffer length, so FFT_N (the capture length)
+*	can be made small to free SRAM without losing the low bands. Once
+*	GOERTZEL_N samples have been seen, the level of every band is written to
+*	goertzel_levels[] on the same scale as fft_levels[] and the filters
+*	restart.
+*
+*	goertzel_sample() is the per sample update, goertzel_block() applies the
+*	same update to a whole captured frame, one band at a time.
+*/
+#ifndef GOERTZEL_H
+#define GOERTZEL_H
+
+#include <stdint.h>
+
+#include "include/fft.h"
+#include "include/hal.h"
+
+// Band centers in Hz, ascending. The defaults are the MSGEQ7 bands.
+#ifndef GOERTZEL_FREQUENCIES
+#define GOERTZEL_FREQUENCIES { 63, 160, 400, 1000, 2500, 6250, 16000 }
+#endif
+
+// Captured frames per analysis, as a power of two.
+#ifndef GOERTZEL_LOG2_BLOCKS
+#define GOERTZEL_LOG2_BLOCKS 3
+#endif
+
+#define GOERTZEL_LOG2N (FFT_LOG2N + GOERTZEL_LOG2_BLOCKS)
+#define GOERTZEL_N (1UL << GOERTZEL_LOG2N)
+
+// Coefficients 2 cos(w) are Q30. For low bands 2 cos(w) is within 2^-14 of
+// 2, so a 16 bit coefficient would move the band center by tens of Hz.
+#define GOERTZEL_COEFF_BITS 30
+
+// Only read by goertzel_init(), so it stays in PROGMEM.
+constexpr uint16_t goertzel_frequencies[] PROGMEM = GOERTZEL_FREQUENCIES;
+constexpr uint8_t goertzel_bands =
+		sizeof(goertzel_frequencies) / sizeof(goertzel_frequencies[0]);
+
+/*
+*	A state grows by at most m |x| at sample m of the analysis, so it stays
+*	below 2^(2 log2(N) - 1 + 15) for Q15 input. The input is scaled down by
+*	2^goertzel_shift to keep that below 2^30, so 2 cos(w) times a state
+*	still fits 32 bits.
+*/
+constexpr uint8_t goertzel_shift =
+		2 * GOERTZEL_LOG2N > 16 ? 2 * GOERTZEL_LOG2N - 16 + 1 : 0;
+
+static_assert(goertzel_shift < 15, "GOERTZEL_N is too long");
+
+struct goertzel_band_t {
+	int32_t coeff;
+	int32_t s1;
+	int32_t s2;
+};
+
+// Stored in the arena, see include/arena.h.
+extern goertzel_band_t (&goertzel_state)[goertzel_bands];
+
+// Level of each band, 16 * log2 |X| like fft_levels[], written every
+// GOERTZEL_N samples.
+extern uint8_t (&goertzel_levels)[goertzel_bands];
+
+// Frames of the current analysis seen by goertzel_block().
+extern uint8_t goertzel_blocks;
+
+// Compute the coefficients for sample rate fs in Hz and reset the filters.
+// Bands at or above fs / 2 stay at level 0.
+void goertzel_init(uint32_t fs);
+
+// Write goertzel_levels[] from the filter states and reset them.
+void goertzel_output();
+
+/*
+*	coeff * s with coeff in Q30, from 16 x 16 bit products so no 32 x 32 bit
+*	multiply is needed on AVR. Near 2 cos(w) = 2 the filter is very
+*	sensitive to rounding, so all four partial products are kept.
+*/
+inline int32_t goertzel_mul(int32_t coeff, int32_t s) {
+	int16_t ch = (int16_t)(coeff >> 16);
+	uint16_t cl = (uint16_t)coeff;
+	int16_t sh = (int16_t)(s >> 16);
+	uint16_t sl = (uint16_t)s;
+	int32_t mid = (((int32_t)ch * sl) >> 2) + (((int32_t)sh * cl) >> 2)
+			+ (int32_t)(((uint32_t)cl * sl) >> 18);
+	return (int32_t)ch * sh * (1 << (32 - GOERTZEL_COEFF_BITS))
+			+ (mid >> (GOERTZEL_COEFF_BITS - 18));
+}
+
+// Advance every filter by one Q15 sample.
+inline void goertzel_sample(fft_sample_t x) {
+	int16_t in = x >> goertzel_shift;
+	for (uint8_t b = 0; b < goertzel_bands; ++b) {
+		goertzel_band_t& g = goertzel_state[b];
+		int32_t s = in + goertzel_mul(g.coeff, g.s1) - g.s2;
+		g.s2 = g.s1;
+		g.s1 = s;
+	}
+}
+
+// Advance one filter over a full frame, equivalent to goertzel_sample()
+// for each sample, but the states stay in registers for the whole frame.
+template <typename Raw>
+inline void goertzel_band(goertzel_band_t& g, const fft_sample_t *x) {
+	const int32_t coeff = g.coeff;
+	int32_t s1 = g.s1;
+	int32_t s2 = g.s2;
+
+	for (uint16_t i = 0; i < FFT_N; ++i) {
+		int32_t s = (fft_from_adc((Raw)x[i]) >> goertzel_shift)
+				+ goertzel_mul(coeff, s1) - s2;
+		s2 = s1;
+		s1 = s;
+	}
+
+	g.s1 = s1;
+	g.s2 = s2;
+}
+
+/*
+*	Feed a full buffer of samples of type Raw (see fft_input()) through the
+*	filters. Returns true if this completed an analysis and
+*	goertzel_levels[] was updated.
+*/
+template <typename Raw, typename Buffer>
+bool goertzel_block(Buffer& buf) {
+	for (uint8_t b = 0; b < goertzel_bands; ++b) {
+		goertzel_band<Raw>(goertzel_state[b], buf.data());
+	}
+
+	if (++goertzel_blocks < (1 << GOERTZEL_LOG2_BLOCKS)) return false;
+	goertzel_blocks = 0;
+	goertzel_output();
+	return true;
+}
+
+#endif
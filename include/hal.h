@@ -0,0 +1,40 @@
+/*
+*	Hardware abstraction for the processing stages.
+*
+*	Everything between capture and output (CircularBuffer, preprocessing,
+*	the FFT, mapping) only needs program memory access and a compiler
+*	barrier from the target. This header provides those for AVR and for a
+*	native host build, so the same sources compile on both, see bench/.
+*
+*	Capture and output remain AVR specific and live in src/visualizer.cpp
+*	and src/ws2812.cpp.
+*/
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+#ifdef __AVR__
+
+#include <avr/pgmspace.h>
+
+#define HAL_AVR 1
+
+#else
+
+// On a von Neumann host program memory is ordinary memory.
+#define PROGMEM
+#define pgm_read_byte(addr)		(*(const uint8_t *)(addr))
+#define pgm_read_word(addr)		(*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)	(*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)		(*(const void * const *)(addr))
+
+#define HAL_AVR 0
+
+#endif
+
+// Keep the compiler from moving memory accesses across this point. AVR does
+// not reorder memory accesses itself, and host builds are single threaded.
+#define HAL_BARRIER() asm volatile("" ::: "memory")
+
+#endif
@@ -0,0 +1,91 @@
+/*
+*	Runtime mode switching.
+*
+*	A mode is a set of bits, each selecting one of two alternatives of a
+*	pipeline stage (see mode_spectral_stage and friends in include/stages.h),
+*	e.g. the spectral engine and the LED effect. The mode is changed from a
+*	button on MODE_PIN, which steps through the modes, or with MODE_SERIAL
+*	by sending the digit of a mode over the serial port.
+*
+*	A request only sets the pending mode. mode_update() makes it current at
+*	the next frame boundary, between two runs of the pipeline, so a frame is
+*	never processed half in one mode and half in another. Capture keeps
+*	running all the while: nothing here disables interrupts or touches the
+*	ADC, and the state of every mode is preallocated (see
+*	include/arena.h), so a switch does not allocate either.
+*/
+#ifndef MODE_H
+#define MODE_H
+
+#include <stdint.h>
+
+// Number of modes, the mode bits run 0..MODE_COUNT - 1.
+#ifndef MODE_COUNT
+#define MODE_COUNT 4
+#endif
+
+// Button to ground, digital pin 2 on an Uno, with the internal pull up.
+#ifndef MODE_BUTTON
+#define MODE_BUTTON 1
+#endif
+
+#ifndef MODE_PORT
+#define MODE_PIN	PIND
+#define MODE_PORT	PORTD
+#define MODE_BIT	PD2
+#endif
+
+// A press is taken once the button has been stable for this long.
+#ifndef MODE_DEBOUNCE_MS
+#define MODE_DEBOUNCE_MS 30
+#endif
+
+// Take '0' + mode from Serial.
+#ifndef MODE_SERIAL
+#define MODE_SERIAL 0
+#endif
+
+#ifndef MODE_BAUD
+#define MODE_BAUD 115200
+#endif
+
+static_assert(MODE_COUNT >= 1 && MODE_COUNT <= 10,
+		"a mode is selected by a single digit");
+
+/*
+*	State of src/mode.cpp. pending is the requested mode, taken by
+*	mode_update(). pressed and last are the debounced and the last read
+*	state of the button, since when it last changed.
+*/
+struct mode_state_t {
+	volatile uint8_t pending;
+	#if MODE_BUTTON
+	bool pressed;
+	bool last;
+	uint16_t since;
+	#endif
+};
+
+// Current mode, only written by mode_update().
+extern uint8_t mode_current;
+
+// True if bit b of the current mode is set.
+inline bool mode_bit(uint8_t b) {
+	return mode_current & (1 << b);
+}
+
+// Configure the button.
+void mode_init();
+
+// Ask for mode m, taken at the next mode_update(). Single byte write, so it
+// may be called from an ISR.
+void mode_request(uint8_t m);
+
+// Read the button and the serial port, and request a mode if asked to.
+void mode_poll();
+
+// At a frame boundary, make a pending mode current. Returns true if the
+// mode changed.
+bool mode_update();
+
+#endif
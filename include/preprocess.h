@@ -0,0 +1,126 @@
+/*
+*	Block preprocessing of a captured frame.
+*
+*	preprocess_block() converts a block of raw ADC readings to Q15 in place
+*	and applies, in the same single pass over the samples,
+*
+*		i.	DC removal. The offset subtracted is a running mean of the
+*			previous frames, so it is known before the pass starts.
+*
+*		ii.	A noise gate. Samples within PREPROCESS_GATE of zero after DC
+*			removal are set to zero, so the idle noise of the input does not
+*			light up the display.
+*
+*		iii.Dynamic range compression. The gain is looked up from
+*			include/drc_table.h by the envelope of the previous frames and is
+*			constant over a frame, so it shapes levels without distorting
+*			the waveform within a frame.
+*
+*	The sum and peak of the frame are collected in the same pass and update
+*	the DC estimate, the envelope and the gain for the next frame once it is
+*	done, in preprocess_update().
+*
+*	The result is what fft_input<fft_sample_t>() expects.
+*/
+#ifndef PREPROCESS_H
+#define PREPROCESS_H
+
+#include <stdint.h>
+
+#include "include/AdcConfig.h"
+#include "include/fft.h"
+#include "include/traits.h"
+
+// Run preprocess_block() before fft_input(). Without it the raw readings are
+// converted by fft_input() directly.
+#ifndef PREPROCESS
+#define PREPROCESS 1
+#endif
+
+// The DC estimate moves 1/2^PREPROCESS_DC_SHIFT of the way to the mean of
+// each frame. 0 disables DC removal.
+#ifndef PREPROCESS_DC_SHIFT
+#define PREPROCESS_DC_SHIFT 3
+#endif
+
+// Gate threshold in Q15, 0 disables the gate. The default is two LSB of an
+// 8 bit reading.
+#ifndef PREPROCESS_GATE
+#define PREPROCESS_GATE 512
+#endif
+
+// Dynamic range compression, see tools/gen_drc_table.py for the curve.
+#ifndef PREPROCESS_DRC
+#define PREPROCESS_DRC 1
+#endif
+
+// The envelope follows a louder frame at once and otherwise moves
+// 1/2^PREPROCESS_RELEASE_SHIFT of the way down to the peak of each frame.
+#ifndef PREPROCESS_RELEASE_SHIFT
+#define PREPROCESS_RELEASE_SHIFT 3
+#endif
+
+// Must match tools/gen_drc_table.py.
+#define PREPROCESS_DRC_LOG2_ENTRIES 6
+#define PREPROCESS_DRC_ENTRIES (1 << PREPROCESS_DRC_LOG2_ENTRIES)
+#define PREPROCESS_DRC_GAIN_BITS 12
+
+struct preprocess_state_t {
+	// Running mean of the input in Q15.
+	int16_t dc;
+	// Envelope of the DC free input in Q15.
+	uint16_t envelope;
+	// Compressor gain for the next frame in Q12.
+	uint16_t gain;
+};
+
+// One state per ADC channel, see ADC_CHANNELS.
+extern preprocess_state_t preprocess_state[ADC_CHANNELS];
+
+// Update the state st from the sum of the 2^log2n converted input samples
+// and the peak magnitude after DC removal of the block that was just
+// processed.
+void preprocess_update(preprocess_state_t& st, int32_t sum, uint16_t peak,
+		uint8_t log2n);
+
+inline int16_t preprocess_saturate(int32_t x) {
+	return x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : (int16_t)x;
+}
+
+/*
+*	Preprocess a block of N raw ADC readings of type Raw of ADC channel ch in
+*	place, N a power of two. This is usually a whole frame, but any block of
+*	new samples works, e.g. each hop of overlapped frames.
+*
+*	The stage switches are compile time constants, so the branches on them
+*	disappear and the loop only contains the enabled steps.
+*/
+template <typename Raw, uint16_t N>
+void preprocess_block(fft_sample_t *x, uint8_t ch = 0) {
+	preprocess_state_t& st = preprocess_state[ch];
+	const int16_t dc = st.dc;
+	const uint16_t gain = st.gain;
+	int32_t sum = 0;
+	uint16_t peak = 0;
+
+	for (uint16_t i = 0; i < N; ++i) {
+		int16_t s = fft_from_adc((Raw)x[i]);
+		sum += s;
+
+		int16_t y = PREPROCESS_DC_SHIFT ? preprocess_saturate((int32_t)s - dc) : s;
+		uint16_t a = y < 0 ? -(uint16_t)y : y;
+		if (a > peak) peak = a;
+
+		if (a <= PREPROCESS_GATE) {
+			y = 0;
+		} else if (PREPROCESS_DRC) {
+			y = preprocess_saturate(
+					((int32_t)y * gain) >> PREPROCESS_DRC_GAIN_BITS);
+		}
+		x[i] = y;
+	}
+
+	preprocess_update(st, sum, peak, static_log2(N));
+}
+
+#endif
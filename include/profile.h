@@ -0,0 +1,148 @@
+/*
+*	Optional per-stage cycle profiling.
+*
+*	With PROFILE set, Timer1 runs at the CPU clock and is extended to 32 bits
+*	by its overflow interrupt, so each PROFILE_BEGIN()/PROFILE_END() pair
+*	measures a stage in CPU cycles (minus the measured overhead of the pair
+*	itself). Each stage keeps min/max/mean over the frames since the last
+*	profile_report(), which prints them together with the number of dropped
+*	frames over Serial.
+*
+*	With PROFILE_GPIO set, PROFILE_PIN is driven high for the duration of
+*	every profiled stage so the pipeline can be watched on a scope. This
+*	needs no timer and costs two cycles per edge. The two can be combined.
+*
+*	With PROFILE_SIM set, the firmware is meant to run under simavr with
+*	bench/simavr.c, which counts cycles exactly. Every marker is a single
+*	out to PROFILE_SIM_REG (one cycle) that the simulator traps on, see the
+*	PROFILE_SIM_* values below. It can not be combined with the other two.
+*
+*	With none set the macros compile to nothing.
+*/
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#ifndef PROFILE
+#define PROFILE 0
+#endif
+
+#ifndef PROFILE_GPIO
+#define PROFILE_GPIO 0
+#endif
+
+#ifndef PROFILE_SIM
+#define PROFILE_SIM 0
+#endif
+
+#if PROFILE_SIM && (PROFILE || PROFILE_GPIO)
+#error "PROFILE_SIM can not be combined with PROFILE or PROFILE_GPIO"
+#endif
+
+// Frames between reports.
+#ifndef PROFILE_REPORT_FRAMES
+#define PROFILE_REPORT_FRAMES 64
+#endif
+
+#ifndef PROFILE_BAUD
+#define PROFILE_BAUD 115200
+#endif
+
+// Scope output, digital pin 12 on an Uno. Must be in the I/O range so that
+// setting and clearing the bit compile to sbi/cbi.
+#ifndef PROFILE_PORT
+#define PROFILE_PORT	PORTB
+#define PROFILE_DDR		DDRB
+#define PROFILE_BIT		PB4
+#endif
+
+// Simulator marker register, unused by the firmware and in the I/O range so
+// that a write is a single out. The values written are a stage ORed with
+// PROFILE_SIM_BEGIN or PROFILE_SIM_END, or PROFILE_SIM_FRAME at the start of
+// every loop(). bench/simavr.c decodes the same values.
+#ifndef PROFILE_SIM_REG
+#define PROFILE_SIM_REG	GPIOR0
+#endif
+
+#define PROFILE_SIM_FRAME	0x20
+#define PROFILE_SIM_END		0x40
+#define PROFILE_SIM_BEGIN	0x80
+
+enum profile_stage_t {
+	PROFILE_PREPROCESS,
+	PROFILE_FFT_INPUT,
+	PROFILE_FFT_EXECUTE,
+	PROFILE_FFT_OUTPUT,
+	PROFILE_OUTPUT,
+	PROFILE_GOERTZEL,
+	PROFILE_BANDS,
+	PROFILE_FADE,
+	PROFILE_COLOR,
+	PROFILE_STAGES
+};
+
+struct profile_stat_t {
+	uint32_t min;
+	uint32_t max;
+	uint32_t sum;
+	uint16_t count;
+};
+
+#if PROFILE_GPIO
+// Make PROFILE_PIN an output.
+void profile_gpio_init();
+#endif
+
+#if PROFILE
+extern profile_stat_t profile_stats[PROFILE_STAGES];
+
+// Only used by src/profile.cpp: the Timer1 overflows, the cycle count at
+// which each stage began and the cost of a begin/end pair.
+extern volatile uint16_t profile_overflows;
+extern uint32_t profile_start[PROFILE_STAGES];
+extern uint16_t profile_overhead;
+
+// Start Timer1 and calibrate the overhead of a begin/end pair.
+void profile_init();
+
+// CPU cycles since profile_init(), wraps after ~268 s at 16 MHz.
+uint32_t profile_cycles();
+
+void profile_begin(uint8_t stage);
+void profile_end(uint8_t stage);
+
+// Print and reset the statistics of every stage.
+void profile_report(uint16_t dropped);
+#endif
+
+#define PROFILE_PIN_HIGH()	(PROFILE_PORT |= _BV(PROFILE_BIT))
+#define PROFILE_PIN_LOW()	(PROFILE_PORT &= ~_BV(PROFILE_BIT))
+
+#if PROFILE_SIM
+	#define PROFILE_BEGIN(stage)	(PROFILE_SIM_REG = PROFILE_SIM_BEGIN | (stage))
+	#define PROFILE_END(stage)		(PROFILE_SIM_REG = PROFILE_SIM_END | (stage))
+#elif PROFILE && PROFILE_GPIO
+	#define PROFILE_BEGIN(stage)	do { PROFILE_PIN_HIGH(); \
+										profile_begin(stage); } while (0)
+	#define PROFILE_END(stage)		do { profile_end(stage); \
+										PROFILE_PIN_LOW(); } while (0)
+#elif PROFILE
+	#define PROFILE_BEGIN(stage)	profile_begin(stage)
+	#define PROFILE_END(stage)		profile_end(stage)
+#elif PROFILE_GPIO
+	#define PROFILE_BEGIN(stage)	PROFILE_PIN_HIGH()
+	#define PROFILE_END(stage)		PROFILE_PIN_LOW()
+#else
+	#define PROFILE_BEGIN(stage)	do {} while (0)
+	#define PROFILE_END(stage)		do {} while (0)
+#endif
+
+// Start of a loop() iteration, only marked for the simulator.
+#if PROFILE_SIM
+	#define PROFILE_FRAME()		(PROFILE_SIM_REG = PROFILE_SIM_FRAME)
+#else
+	#define PROFILE_FRAME()		do {} while (0)
+#endif
+
+#endif
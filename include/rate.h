@@ -0,0 +1,125 @@
+/*
+*	Adaptive sample rate.
+*
+*	The frame length in time is FFT_N conversions per channel, so it is set
+*	by the ADC prescaler. When processing a frame (and drawing the LED
+*	frames in between) takes longer than capturing the next one, frames are
+*	dropped, and when it takes a fraction of it, resolution is wasted on a
+*	rate the pipeline could not use anyway. How long a frame takes depends
+*	on the mode, so no single prescaler suits every configuration.
+*
+*	With RATE_ADAPT set, the time loop() spends outside the wait for the
+*	next frame is measured with micros() for every frame. Once every
+*	RATE_WINDOW frames, if a frame was dropped or the busiest one took more
+*	than RATE_HIGH percent of the frame period, the prescaler is doubled,
+*	which doubles the period. If the busiest one took less than RATE_LOW
+*	percent, it is halved again, down to RATE_MIN_PRESCALER. RATE_LOW is
+*	below half of RATE_HIGH, so a step down is not undone by the next
+*	window.
+*
+*	A new prescaler is written to ADCSRA at a frame boundary and the stages
+*	that depend on the sample rate are restarted: the band map of the new
+*	rate is taken from PROGMEM, where one is stored for every prescaler
+*	from RATE_MIN_PRESCALER to RATE_MAX_PRESCALER, and the Goertzel
+*	coefficients are recomputed. FFT_N and the capture buffers stay as
+*	built. The frames already queued were captured at the previous rate and
+*	are analysed at the new one, which only shows for a frame or two.
+*
+*	The sample format (adc_config::bits) is fixed at build time, so it must
+*	be valid at every prescaler in the range.
+*/
+#ifndef RATE_H
+#define RATE_H
+
+#include <stdint.h>
+
+#include "include/AdcConfig.h"
+
+#ifndef RATE_ADAPT
+#define RATE_ADAPT 0
+#endif
+
+// Range of the prescaler. The build time ADC_PRESCALER is where it starts.
+#ifndef RATE_MIN_PRESCALER
+#define RATE_MIN_PRESCALER ADC_PRESCALER
+#endif
+
+#ifndef RATE_MAX_PRESCALER
+#define RATE_MAX_PRESCALER (RATE_ADAPT ? 128 : ADC_PRESCALER)
+#endif
+
+// Frames per decision.
+#ifndef RATE_WINDOW
+#define RATE_WINDOW 32
+#endif
+
+// Busy share of the frame period, in percent, above which the rate is
+// lowered and below which it is raised.
+#ifndef RATE_HIGH
+#define RATE_HIGH 90
+#endif
+
+#ifndef RATE_LOW
+#define RATE_LOW 40
+#endif
+
+constexpr uint8_t rate_steps =
+		adc_adps(RATE_MAX_PRESCALER) - adc_adps(RATE_MIN_PRESCALER) + 1;
+
+static_assert(adc_effective_bits(RATE_MIN_PRESCALER)
+		&& adc_effective_bits(RATE_MAX_PRESCALER)
+		&& RATE_MIN_PRESCALER <= ADC_PRESCALER
+		&& ADC_PRESCALER <= RATE_MAX_PRESCALER,
+		"RATE_MIN_PRESCALER..RATE_MAX_PRESCALER must be prescalers around "
+		"ADC_PRESCALER");
+static_assert(adc_config::bits <= adc_effective_bits(RATE_MIN_PRESCALER),
+		"ADC_BITS must be valid at RATE_MIN_PRESCALER");
+static_assert(RATE_LOW * 2 < RATE_HIGH && RATE_HIGH <= 100,
+		"RATE_LOW must be below half of RATE_HIGH");
+
+/*
+*	State of src/rate.cpp: when the current busy period started, the longest
+*	one and the frames of the current window, and the dropped frames at its
+*	start.
+*/
+struct rate_state_t {
+	uint32_t busy_start;
+	uint32_t busy_max;
+	uint16_t dropped;
+	uint8_t frames;
+};
+
+#if RATE_ADAPT
+// Prescaler RATE_MIN_PRESCALER << rate_step, only written by rate_update().
+extern uint8_t rate_step;
+#else
+static const uint8_t rate_step =
+		adc_adps(ADC_PRESCALER) - adc_adps(RATE_MIN_PRESCALER);
+#endif
+
+inline uint16_t rate_prescaler() {
+	return RATE_MIN_PRESCALER << rate_step;
+}
+
+// Sample rate of each channel at the current prescaler.
+inline uint32_t rate_fs() {
+	return adc_fs(rate_prescaler());
+}
+
+#if RATE_ADAPT
+// Start a new window, after setup() and whenever the pipeline has been
+// restarted, so the restart itself is not taken for processing time.
+void rate_restart();
+
+// Call when loop() starts waiting for a frame and once it has one. The time
+// from one rate_wait_end() to the next rate_wait_begin() is busy.
+void rate_wait_begin();
+void rate_wait_end();
+
+// At a frame boundary, change the prescaler if the last RATE_WINDOW frames
+// ask for it, dropped being the frames lost since startup. Returns true if
+// it changed.
+bool rate_update(uint16_t dropped);
+#endif
+
+#endif
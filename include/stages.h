@@ -0,0 +1,281 @@
+/*
+*	Stages of the processing pipeline that do not depend on the target, see
+*	include/Pipeline.h for what each kind of stage provides.
+*/
+#ifndef STAGES_H
+#define STAGES_H
+
+#include <stdint.h>
+
+#include "include/bands.h"
+#include "include/color.h"
+#include "include/eq.h"
+#include "include/fade.h"
+#include "include/fft.h"
+#include "include/goertzel.h"
+#include "include/mode.h"
+#include "include/preprocess.h"
+#include "include/profile.h"
+#include "include/rate.h"
+#include "include/telemetry.h"
+#include "include/traits.h"
+
+/*
+*	C. Preprocessing.
+*/
+
+// Samples are passed on as captured.
+struct no_preprocess_stage {
+	static const bool enabled = false;
+
+	template <typename Raw>
+	struct input { typedef Raw type; };
+
+	template <typename Raw, uint16_t N>
+	static void block(fft_sample_t *, uint8_t = 0) {}
+};
+
+// DC removal, noise gate and compression, see include/preprocess.h.
+struct preprocess_stage {
+	static const bool enabled = true;
+
+	template <typename Raw>
+	struct input { typedef fft_sample_t type; };
+
+	template <typename Raw, uint16_t N>
+	static void block(fft_sample_t *x, uint8_t ch = 0) {
+		preprocess_block<Raw, N>(x, ch);
+	}
+};
+
+/*
+*	D. Spectral analysis.
+*/
+
+struct fft_stage {
+	static void init() {}
+
+	template <typename Input, typename Buffer>
+	static bool process(Buffer& buf, bool_type<true>) {
+		PROFILE_BEGIN(PROFILE_FFT_INPUT);
+		fft_input<Input>(buf);
+		PROFILE_END(PROFILE_FFT_INPUT);
+		return transform();
+	}
+
+	#if FFT_LOAD
+	// The buffer is still being written, so the frame is loaded rather than
+	// transformed in place.
+	template <typename Input, typename Buffer>
+	static bool process(const Buffer& buf, bool_type<false>) {
+		PROFILE_BEGIN(PROFILE_FFT_INPUT);
+		fft_load<Input>(buf);
+		PROFILE_END(PROFILE_FFT_INPUT);
+		return transform();
+	}
+	#endif
+
+	static const uint8_t *levels() { return fft_levels; }
+
+	static uint8_t count() { return FFT_BINS; }
+
+	private:
+		static bool transform() {
+			PROFILE_BEGIN(PROFILE_FFT_EXECUTE);
+			fft_execute();
+			PROFILE_END(PROFILE_FFT_EXECUTE);
+			PROFILE_BEGIN(PROFILE_FFT_OUTPUT);
+			fft_output();
+			PROFILE_END(PROFILE_FFT_OUTPUT);
+			return true;
+		}
+};
+
+// The levels only change once per analysis of GOERTZEL_N samples.
+struct goertzel_stage {
+	static void init() { goertzel_init(rate_fs()); }
+
+	template <typename Input, typename Buffer>
+	static bool process(Buffer& buf, bool_type<true>) {
+		PROFILE_BEGIN(PROFILE_GOERTZEL);
+		bool updated = goertzel_block<Input>(buf);
+		PROFILE_END(PROFILE_GOERTZEL);
+		return updated;
+	}
+
+	static const uint8_t *levels() { return goertzel_levels; }
+
+	static uint8_t count() { return goertzel_bands; }
+};
+
+/*
+*	E. and F.i. From spectral levels to channels.
+*/
+
+// The spectral levels are the channels, e.g. for the Goertzel bands.
+struct identity_stage {
+	static void init() {}
+
+	static const uint8_t *process(const uint8_t *levels, uint8_t&) {
+		return levels;
+	}
+};
+
+// FFT bins to equalized bands, see include/bands.h and include/eq.h.
+template <const eq_table_t *Preset>
+struct bands_stage {
+	static void init() { eq_load(Preset); }
+
+	static const uint8_t *process(const uint8_t *levels, uint8_t& n) {
+		PROFILE_BEGIN(PROFILE_BANDS);
+		bands_aggregate(levels);
+		PROFILE_END(PROFILE_BANDS);
+		n = BANDS_COUNT;
+		return band_levels;
+	}
+};
+
+/*
+*	F.ii to F.iv. Fading, color and movement on a strip of Pixels pixels.
+*/
+
+// A run of pixels per channel, only the channels that changed are drawn.
+template <uint16_t Pixels, uint8_t Segment>
+struct channels_map_stage {
+	static_assert(Pixels >= FADE_CHANNELS, "at least a pixel per channel");
+
+	static const uint16_t pixels = Pixels;
+	static const uint8_t segment = Segment;
+
+	// The strip may hold another effect, so every pixel is drawn again.
+	static void init() { fade_mark_all(); }
+
+	static void input(const uint8_t *levels, uint8_t n, uint8_t first) {
+		fade_input(levels, n, first);
+	}
+
+	template <typename Strip>
+	static void frame(Strip& strip) {
+		PROFILE_BEGIN(PROFILE_FADE);
+		fade_step();
+		PROFILE_END(PROFILE_FADE);
+		PROFILE_BEGIN(PROFILE_COLOR);
+		color_render(strip);
+		fade_clean();
+		PROFILE_END(PROFILE_COLOR);
+	}
+};
+
+// The strip moves up by a pixel per LED frame and the loudest channel
+// enters at the start.
+template <uint16_t Pixels, uint8_t Segment>
+struct scroll_map_stage {
+	static const uint16_t pixels = Pixels;
+	static const uint8_t segment = Segment;
+
+	// Whatever is on the strip scrolls out.
+	static void init() {}
+
+	static void input(const uint8_t *levels, uint8_t n, uint8_t first) {
+		fade_input(levels, n, first);
+	}
+
+	template <typename Strip>
+	static void frame(Strip& strip) {
+		PROFILE_BEGIN(PROFILE_FADE);
+		fade_step();
+		PROFILE_END(PROFILE_FADE);
+		PROFILE_BEGIN(PROFILE_COLOR);
+		color_scroll(strip);
+		fade_clean();
+		PROFILE_END(PROFILE_COLOR);
+	}
+};
+
+// Streams the channel levels before passing them on to Map, see
+// include/telemetry.h.
+template <typename Map>
+struct telemetry_map_stage {
+	static const uint16_t pixels = Map::pixels;
+	static const uint8_t segment = Map::segment;
+
+	static void init() { Map::init(); }
+
+	static void input(const uint8_t *levels, uint8_t n, uint8_t first) {
+		#if TELEMETRY
+		telemetry_levels(levels, n, first);
+		#endif
+		Map::input(levels, n, first);
+	}
+
+	template <typename Strip>
+	static void frame(Strip& strip) { Map::frame(strip); }
+};
+
+/*
+*	Runtime selection between two stages A and B by bit Bit of the mode, see
+*	include/mode.h. The mode only changes between frames, when the pipeline
+*	is restarted, so the selected stage is initialized before it runs.
+*/
+
+template <uint8_t Bit, typename A, typename B>
+struct mode_spectral_stage {
+	static void init() {
+		if (mode_bit(Bit)) B::init();
+		else A::init();
+	}
+
+	template <typename Input, typename Buffer, typename InPlace>
+	static bool process(Buffer& buf, InPlace in_place) {
+		if (mode_bit(Bit)) return B::template process<Input>(buf, in_place);
+		return A::template process<Input>(buf, in_place);
+	}
+
+	static const uint8_t *levels() {
+		return mode_bit(Bit) ? B::levels() : A::levels();
+	}
+
+	static uint8_t count() {
+		return mode_bit(Bit) ? B::count() : A::count();
+	}
+};
+
+template <uint8_t Bit, typename A, typename B>
+struct mode_post_stage {
+	static void init() {
+		if (mode_bit(Bit)) B::init();
+		else A::init();
+	}
+
+	static const uint8_t *process(const uint8_t *levels, uint8_t& n) {
+		if (mode_bit(Bit)) return B::process(levels, n);
+		return A::process(levels, n);
+	}
+};
+
+template <uint8_t Bit, typename A, typename B>
+struct mode_map_stage {
+	static_assert(A::pixels == B::pixels && A::segment == B::segment,
+			"both effects draw the same strip");
+
+	static const uint16_t pixels = A::pixels;
+	static const uint8_t segment = A::segment;
+
+	static void init() {
+		if (mode_bit(Bit)) B::init();
+		else A::init();
+	}
+
+	static void input(const uint8_t *levels, uint8_t n, uint8_t first) {
+		if (mode_bit(Bit)) B::input(levels, n, first);
+		else A::input(levels, n, first);
+	}
+
+	template <typename Strip>
+	static void frame(Strip& strip) {
+		if (mode_bit(Bit)) B::frame(strip);
+		else A::frame(strip);
+	}
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+*	Binary telemetry over the USART, for watching what the device sees.
+*
+*	Every message is a type byte, a sequence number, the payload and a
+*	CRC-8 (polynomial 0x07, initial value 0, as _crc8_ccitt_update() of
+*	avr-libc) over all of them, COBS encoded and terminated by a zero byte,
+*	so a receiver can start anywhere in the stream and resynchronizes at the
+*	next zero. Multi-byte fields are little endian.
+*
+*	TELEMETRY_LEVELS	first, n, then n channel levels, as passed from the
+*						Post to the Map stage, see telemetry_map_stage.
+*	TELEMETRY_STATUS	frames dropped by capture (16 bits), messages dropped
+*						here (16 bits), the mode and the ADC prescaler (16
+*						bits), every TELEMETRY_STATUS_FRAMES frames.
+*	TELEMETRY_PROFILE	stage, count (16 bits), min, max and mean (32 bits
+*						each) in CPU cycles, one message per stage in place
+*						of the text of profile_report() when PROFILE is set.
+*
+*	A message is encoded straight into a TELEMETRY_BUFFER byte ring, which
+*	the USART data register empty interrupt drains, so sending never waits
+*	on the line. loop() only publishes a message once it is complete, and
+*	if there is not room for all of it, it is dropped whole and counted.
+*	tools/telemetry_plot.py decodes and plots the stream.
+*
+*	The USART runs asynchronously at TELEMETRY_BAUD, TX only on TXD (PD1,
+*	digital pin 1 on an Uno). This takes the USART from Serial and from
+*	OUTPUT_WS2812, and as Serial would define the same interrupt vectors,
+*	nothing else may use Serial.
+*/
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#include "include/AdcConfig.h"
+#include "include/profile.h"
+
+#ifndef TELEMETRY
+#define TELEMETRY 0
+#endif
+
+// 1 Mbaud is exact with U2X at 16 MHz.
+#ifndef TELEMETRY_BAUD
+#define TELEMETRY_BAUD 1000000UL
+#endif
+
+// Size of the TX ring, a power of two of at most 256.
+#ifndef TELEMETRY_BUFFER
+#define TELEMETRY_BUFFER 128
+#endif
+
+// Pipeline frames between two TELEMETRY_STATUS messages.
+#ifndef TELEMETRY_STATUS_FRAMES
+#define TELEMETRY_STATUS_FRAMES 64
+#endif
+
+#define TELEMETRY_LEVELS	1
+#define TELEMETRY_STATUS	2
+#define TELEMETRY_PROFILE	3
+
+static_assert((TELEMETRY_BUFFER & (TELEMETRY_BUFFER - 1)) == 0
+		&& TELEMETRY_BUFFER <= 256,
+		"TELEMETRY_BUFFER must be a power of two no larger than 256");
+
+// UBRR0 with U2X0 set, and the baud rate it gives.
+constexpr uint16_t telemetry_ubrr =
+		(F_CPU + 4 * TELEMETRY_BAUD) / (8 * TELEMETRY_BAUD) - 1;
+constexpr uint32_t telemetry_baud = F_CPU / (8UL * (telemetry_ubrr + 1));
+
+static_assert(telemetry_baud * 50 >= TELEMETRY_BAUD * 49
+		&& telemetry_baud * 50 <= TELEMETRY_BAUD * 51,
+		"F_CPU gives no UART rate within 2% of TELEMETRY_BAUD");
+
+/*
+*	Indices and counters of src/telemetry.cpp. head, the published end of
+*	the queued messages, is only written by loop() and tail, the next byte
+*	to send, only by the ISR. They are single bytes, so no locking. pos,
+*	code, run and crc belong to the message being encoded: its next byte,
+*	the pending COBS code byte and the length of its block so far, and the
+*	CRC.
+*/
+struct telemetry_state_t {
+	volatile uint8_t head;
+	volatile uint8_t tail;
+	uint8_t pos;
+	uint8_t code;
+	uint8_t run;
+	uint8_t crc;
+	uint8_t seq;
+	uint16_t lost;
+	uint8_t frames;
+};
+
+#if TELEMETRY
+extern uint8_t telemetry_buffer[TELEMETRY_BUFFER];
+
+// Set up the USART. Interrupts must be enabled for anything to be sent.
+void telemetry_init();
+
+// Queue n channel levels from channel first on.
+void telemetry_levels(const uint8_t *levels, uint8_t n, uint8_t first);
+
+// Count a pipeline frame, dropped being the frames lost by capture since
+// startup, and queue the status when it is due.
+void telemetry_frame(uint16_t dropped);
+
+#if PROFILE
+// Queue the statistics of a stage.
+void telemetry_profile(uint8_t stage, const profile_stat_t& stat);
+#endif
+#endif
+
+#endif
@@ -0,0 +1,27 @@
+/*
+*	Minimal compile time type utilities, <type_traits> is not available on
+*	AVR.
+*/
+#ifndef TRAITS_H
+#define TRAITS_H
+
+#include <stdint.h>
+
+// select_type<B, T, F>::type is T if B is true, F otherwise.
+template <bool B, typename T, typename F>
+struct select_type { typedef T type; };
+
+template <typename T, typename F>
+struct select_type<false, T, F> { typedef F type; };
+
+// A distinct type for each of true and false, to select an overload at
+// compile time.
+template <bool B>
+struct bool_type { static const bool value = B; };
+
+// log2 of a power of two n.
+constexpr uint8_t static_log2(uint32_t n) {
+	return n <= 1 ? 0 : 1 + static_log2(n >> 1);
+}
+
+#endif
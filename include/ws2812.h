@@ -0,0 +1,65 @@
+/*
+*	WS2812 output (section G of src/visualizer.cpp) on the USART in master
+*	SPI mode, which keeps interrupts enabled while the LEDs are written.
+*
+*	A bit banged WS2812 driver has to disable interrupts for the whole
+*	frame, since an ADC interrupt in the middle of a high pulse turns a 0
+*	into a 1. Here the USART shifts the waveform out by itself: every LED
+*	bit is four SPI bits of WS2812_BIT_NS, 1000 for a 0 and 1100 for a 1, so
+*	each USART byte carries two LED bits and ends low. An interrupt that
+*	delays the next byte only stretches a low period, which the LEDs ignore
+*	up to their reset time of about 50 us, far longer than any ISR here.
+*
+*	The data line is TXD (PD1, digital pin 1 on an Uno), so the USART can
+*	not be used for Serial at the same time. XCK (PD4) is driven as the SPI
+*	clock and can not be used either.
+*/
+#ifndef WS2812_H
+#define WS2812_H
+
+#include <stdint.h>
+
+#include "include/AdcConfig.h"
+
+// SPI bit rate F_CPU / (2 (UBRR + 1)), as close to 375 ns per bit as the
+// clock allows.
+constexpr uint8_t ws2812_ubrr = (uint8_t)((F_CPU + 2666666UL) / 5333333UL - 1);
+constexpr uint32_t ws2812_bit_ns =
+		2000000000ULL * (ws2812_ubrr + 1) / F_CPU;
+
+// A 0 is high for one bit, a 1 for two. The WS2812B wants T0H 400 +-150 ns
+// and T1H 800 +-150 ns, so T0H allows 250..550 ns per bit, but T1H, twice
+// the bit, only 325..475 ns, which is the limit.
+static_assert(ws2812_bit_ns >= 325 && ws2812_bit_ns <= 475,
+		"F_CPU gives no SPI bit rate that meets the WS2812 timing");
+
+// Framebuffer encoder, the wire format is the G, R, B pixel itself, so the
+// back buffer is sent as it is. ws2812_show() returns once the frame is out,
+// before anything is drawn into it again.
+struct ws2812_encoder {
+	static const uint8_t bytes = 3;
+	static const bool identity = true;
+
+	static void encode(uint8_t *dst, const uint8_t *grb) {
+		dst[0] = grb[0];
+		dst[1] = grb[1];
+		dst[2] = grb[2];
+	}
+};
+
+// SPI patterns of two LED bits, indexed by the bits MSB first. In SRAM, as
+// ws2812_show() reads one for every byte it sends.
+extern const uint8_t ws2812_patterns[4];
+
+// Put the USART into master SPI mode at the WS2812 bit rate.
+void ws2812_init();
+
+/*
+*	Write n pixels of three bytes each, in G, R, B order. Returns once the
+*	last bit is out, about 36 us per pixel. Interrupts stay enabled. The
+*	next call must not come before the LEDs latched (line low for at least
+*	50 us, 280 us for the WS2812B-V5).
+*/
+void ws2812_show(const uint8_t *grb, uint16_t n);
+
+#endif
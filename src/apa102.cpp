@@ -0,0 +1,55 @@
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "include/apa102.h"
+
+#define APA102_START_BYTES 4
+
+static apa102_state_t apa102_state;
+
+static_assert(APA102_SPI_DIVIDER == 16, "SPCR is set for F_CPU / 16");
+
+void apa102_init() {
+	DDRB |= _BV(PB2) | _BV(PB3) | _BV(PB5);
+	SPCR = _BV(SPIE) | _BV(SPE) | _BV(MSTR) | _BV(SPR0);
+	SPSR = 0;
+}
+
+bool apa102_busy() {
+	return apa102_state.streaming;
+}
+
+/*
+*	The end frame has to supply an extra clock edge for every two pixels,
+*	since each pixel delays the data by half a clock. Zeros are sent rather
+*	than the 0xff of the datasheet, which SK9822 clones would latch as a
+*	white pixel past the end of the strip.
+*/
+void apa102_show(const uint8_t *wire, uint16_t n, uint16_t start) {
+	apa102_state.begin = wire;
+	apa102_state.end = wire + 4 * n;
+	apa102_state.ptr = wire + 4 * start;
+	apa102_state.left = 4 * n;
+	apa102_state.zeros = APA102_START_BYTES - 1;
+	apa102_state.tail = (uint8_t)((n + 15) / 16);
+	apa102_state.streaming = true;
+
+	// The rest of the start frame, then the pixels and the end frame are
+	// sent from the interrupt.
+	SPDR = 0;
+}
+
+ISR(SPI_STC_vect) {
+	if (apa102_state.zeros) {
+		--apa102_state.zeros;
+		SPDR = 0;
+	} else if (apa102_state.left) {
+		SPDR = *apa102_state.ptr++;
+		if (apa102_state.ptr == apa102_state.end) {
+			apa102_state.ptr = apa102_state.begin;
+		}
+		if (!--apa102_state.left) apa102_state.zeros = apa102_state.tail;
+	} else {
+		apa102_state.streaming = false;
+	}
+}
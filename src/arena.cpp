@@ -0,0 +1,12 @@
+#include "include/arena.h"
+
+arena_t arena;
+
+#if FFT_LOAD
+fft_complex_t (&fft_cplx_work)[FFT_CPLX_N] = arena.spectral.fft.work;
+#endif
+uint8_t (&fft_levels)[FFT_BINS] = arena.spectral.fft.levels;
+
+goertzel_band_t (&goertzel_state)[goertzel_bands] =
+		arena.spectral.goertzel.bands;
+uint8_t (&goertzel_levels)[goertzel_bands] = arena.spectral.goertzel.levels;
@@ -0,0 +1,46 @@
+#include "include/bands.h"
+#include "include/eq.h"
+#include "include/rate.h"
+
+uint8_t band_levels[BANDS_COUNT];
+
+// A table per prescaler of the rate controller, see include/rate.h.
+struct bands_rate_tables_t {
+	bands_table_t table[rate_steps];
+};
+
+template <uint8_t... S>
+constexpr bands_rate_tables_t bands_make_rate_tables(bands_seq<S...>) {
+	return {{ bands_make_table(bands_make_seq<BANDS_COUNT>::type(),
+			adc_fs(RATE_MIN_PRESCALER << S))... }};
+}
+
+// The highest rate has the widest bins, so the low bands are widened the
+// most there.
+static_assert(bands_edge(BANDS_COUNT, adc_fs(RATE_MIN_PRESCALER)) <= FFT_BINS,
+		"BANDS_COUNT bands do not fit the bins at RATE_MIN_PRESCALER");
+
+static const bands_rate_tables_t bands_tables PROGMEM =
+		bands_make_rate_tables(bands_make_seq<rate_steps>::type());
+
+/*
+*	The bands are contiguous, so the bins are read in order exactly once.
+*	A sum of at most 128 levels fits 16 bits. The equalizer offset of each
+*	band is added here rather than in a pass of its own.
+*/
+void bands_aggregate(const uint8_t *levels) {
+	const bands_table_t& table = bands_tables.table[rate_step];
+	const uint8_t *bin = levels + pgm_read_byte(&table.band[0].first);
+
+	for (uint8_t b = 0; b < BANDS_COUNT; ++b) {
+		uint8_t width = pgm_read_byte(&table.band[b].width);
+		uint16_t reciprocal = pgm_read_word(&table.band[b].reciprocal);
+
+		uint16_t sum = 0;
+		for (uint8_t k = 0; k < width; ++k) sum += *bin++;
+
+		int16_t level = (int16_t)(((uint32_t)sum * reciprocal) >> 15)
+				+ eq_offsets[b];
+		band_levels[b] = level < 0 ? 0 : level > 255 ? 255 : (uint8_t)level;
+	}
+}
@@ -0,0 +1,4 @@
+#include "include/color.h"
+#include "include/color_tables.h"
+
+uint8_t color_hue_offset;
@@ -0,0 +1,25 @@
+#include "include/eq.h"
+
+const eq_table_t eq_flat PROGMEM =
+		eq_make_flat(bands_make_seq<EQ_BANDS>::type());
+const eq_table_t eq_pink PROGMEM =
+		eq_make_pink(bands_make_seq<EQ_BANDS>::type());
+const eq_table_t eq_mic PROGMEM =
+		eq_make_mic(bands_make_seq<EQ_BANDS>::type());
+
+int8_t eq_offsets[EQ_BANDS];
+
+void eq_load(const eq_table_t *table) {
+	for (uint8_t b = 0; b < EQ_BANDS; ++b) {
+		eq_set(b, pgm_read_word(&table->gain[b]));
+	}
+}
+
+/*
+*	16 * log2(gain / 256) from the Q8 log2 of fft_log2(). A gain of 0 mutes
+*	the band as far as an offset can.
+*/
+void eq_set(uint8_t band, uint16_t gain) {
+	int16_t offset = gain ? (int16_t)(fft_log2(gain) >> 4) - 16 * 8 : -128;
+	eq_offsets[band] = offset > 127 ? 127 : offset < -128 ? -128 : (int8_t)offset;
+}
@@ -0,0 +1,67 @@
+#include "include/fade.h"
+
+uint8_t fade_levels[FADE_CHANNELS];
+
+#if FADE_PEAKS
+uint8_t fade_peaks[FADE_CHANNELS];
+uint8_t fade_holds[FADE_CHANNELS];
+#endif
+
+uint8_t fade_dirty[FADE_DIRTY_BYTES];
+
+static inline void fade_mark(uint8_t ch) {
+	fade_dirty[ch >> 3] |= 1 << (ch & 7);
+}
+
+void fade_input(const uint8_t *levels, uint8_t n, uint8_t first) {
+	for (uint8_t ch = first; ch < first + n; ++ch) {
+		uint8_t level = *levels++;
+		if (level > fade_levels[ch]) {
+			fade_levels[ch] = level;
+			fade_mark(ch);
+		}
+		#if FADE_PEAKS
+		if (level >= fade_peaks[ch]) {
+			if (level > fade_peaks[ch]) fade_mark(ch);
+			fade_peaks[ch] = level;
+			fade_holds[ch] = FADE_HOLD;
+		}
+		#endif
+	}
+}
+
+/*
+*	The + 1 of the decay takes a level all the way to 0 rather than leaving
+*	it stuck at the last value where the shift rounds to 0.
+*/
+bool fade_step() {
+	bool changed = false;
+
+	for (uint8_t ch = 0; ch < FADE_CHANNELS; ++ch) {
+		uint8_t level = fade_levels[ch];
+		bool moved = false;
+
+		if (level) {
+			uint8_t decay = (level >> FADE_SHIFT) + 1;
+			fade_levels[ch] = level = level > decay ? level - decay : 0;
+			moved = true;
+		}
+
+		#if FADE_PEAKS
+		uint8_t peak = fade_peaks[ch];
+		if (fade_holds[ch]) {
+			--fade_holds[ch];
+		} else if (peak > level) {
+			fade_peaks[ch] = peak > level + FADE_FALL ? peak - FADE_FALL : level;
+			moved = true;
+		}
+		#endif
+
+		if (moved) {
+			fade_mark(ch);
+			changed = true;
+		}
+	}
+
+	return changed;
+}
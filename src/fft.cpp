@@ -0,0 +1,266 @@
+#include "include/hal.h"
+#include "include/fft.h"
+#include "include/fft_butterfly.h"
+#include "include/fft_tables.h"
+
+fft_complex_t *fft_work;
+
+/*
+*	Look up cos and sin of 2*pi*a/FFT_TABLE_N.
+*
+*	Only a quarter wave is stored, the other quadrants are reflections of it.
+*	This is called once per butterfly group rather than once per butterfly,
+*	so the branch is not in the inner loop.
+*/
+static inline void fft_twiddle(uint16_t a, int16_t& c, int16_t& s) {
+	const uint16_t quarter = FFT_TABLE_N / 4;
+
+	a &= FFT_TABLE_N - 1;
+	uint16_t r = a & (quarter - 1);
+	int16_t sin_r = pgm_read_word(&fft_sin_table[r]);
+	int16_t cos_r = pgm_read_word(&fft_sin_table[quarter - r]);
+
+	switch (a / quarter) {
+	case 0:	c = cos_r;	s = sin_r;	break;
+	case 1:	c = -sin_r;	s = cos_r;	break;
+	case 2:	c = -cos_r;	s = -sin_r;	break;
+	default:	c = sin_r;	s = -cos_r;	break;
+	}
+}
+
+/*
+*	Multiply b by the forward twiddle factor c - j*s.
+*
+*	The product is returned at half scale (Q30 >> 16 instead of >> 15), which
+*	is the 1/2 every butterfly applies anyway and keeps the following sums
+*	within 16 bits. On AVR the shift by 16 is just taking the high word.
+*/
+static inline void fft_rotate(const fft_complex_t& b, int16_t c, int16_t s,
+		fft_complex_t& t) {
+	t.re = (int16_t)(((int32_t)b.re * c + (int32_t)b.im * s) >> 16);
+	t.im = (int16_t)(((int32_t)b.im * c - (int32_t)b.re * s) >> 16);
+}
+
+uint8_t fft_bit_reverse_index(uint8_t i, uint8_t log2n) {
+	return pgm_read_byte(&fft_bitrev_table[i]) >> (8 - log2n);
+}
+
+/*
+*	Radix-2 stage with a butterfly span of h.
+*
+*	Butterflies are visited group-major so each twiddle is fetched once and
+*	reused for every group in the stage.
+*/
+static void fft_radix2_stage(fft_complex_t *x, uint16_t n, uint16_t h) {
+	const uint16_t step = FFT_TABLE_N / (2 * h);
+	const uint16_t count = n / (2 * h);
+
+	for (uint16_t j = 0; j < h; ++j) {
+		int16_t c, s;
+		fft_twiddle(j * step, c, s);
+		fft_butterflies(x + j, h, count, c, s);
+	}
+}
+
+void fft_radix2(fft_complex_t *x, uint8_t log2n) {
+	const uint16_t n = 1 << log2n;
+
+	for (uint16_t h = 1; h < n; h <<= 1) {
+		fft_radix2_stage(x, n, h);
+	}
+}
+
+/*
+*	Radix-4 decimation in time on bit-reversed input.
+*
+*	With bit-reversed (rather than base-4 digit-reversed) input, the four
+*	sub-transforms of each group are stored in the order F0, F2, F1, F3, so
+*	the middle two inputs of each butterfly swap their twiddle factors.
+*	Each stage scales by 1/4, matching two radix-2 stages.
+*/
+void fft_radix4(fft_complex_t *x, uint8_t log2n) {
+	const uint16_t n = 1 << log2n;
+	uint16_t h = 1;
+
+	if (log2n & 1) {
+		fft_radix2_stage(x, n, 1);
+		h = 2;
+	}
+
+	for (; h < n; h <<= 2) {
+		const uint16_t step = FFT_TABLE_N / (4 * h);
+
+		for (uint16_t k = 0; k < h; ++k) {
+			int16_t c1, s1, c2, s2, c3, s3;
+			fft_twiddle(k * step, c1, s1);
+			fft_twiddle(2 * k * step, c2, s2);
+			fft_twiddle(3 * k * step, c3, s3);
+
+			for (uint16_t i = k; i < n; i += 4 * h) {
+				fft_complex_t *p = &x[i];
+				fft_complex_t a, b, c, d;
+
+				// Every term is at half scale after this.
+				a.re = p[0].re >> 1;
+				a.im = p[0].im >> 1;
+				fft_rotate(p[h], c2, s2, b);
+				fft_rotate(p[2 * h], c1, s1, c);
+				fft_rotate(p[3 * h], c3, s3, d);
+
+				int16_t t0re = a.re + b.re, t0im = a.im + b.im;
+				int16_t t1re = a.re - b.re, t1im = a.im - b.im;
+				int16_t t2re = c.re + d.re, t2im = c.im + d.im;
+				int16_t t3re = c.re - d.re, t3im = c.im - d.im;
+
+				t0re >>= 1; t0im >>= 1;
+				t1re >>= 1; t1im >>= 1;
+				t2re >>= 1; t2im >>= 1;
+				t3re >>= 1; t3im >>= 1;
+
+				p[0].re = t0re + t2re;
+				p[0].im = t0im + t2im;
+				p[2 * h].re = t0re - t2re;
+				p[2 * h].im = t0im - t2im;
+				// t1 - j*t3 and t1 + j*t3.
+				p[h].re = t1re + t3im;
+				p[h].im = t1im - t3re;
+				p[3 * h].re = t1re - t3im;
+				p[3 * h].im = t1im + t3re;
+			}
+		}
+	}
+}
+
+/*
+*	Split the transform Z of z[n] = x[2n] + j*x[2n+1] into the transform X of
+*	the real sequence x. With M = N/2, for k = 0..M-1:
+*
+*		E[k] = (Z[k] + conj(Z[M-k])) / 2		transform of the even samples
+*		O[k] = (Z[k] - conj(Z[M-k])) / 2j		transform of the odd samples
+*		X[k] = E[k] + W^k * O[k]
+*		X[M-k] = conj(E[k] - W^k * O[k])
+*
+*	so bins k and M-k are computed together from Z[k] and Z[M-k] in place.
+*	The input was halved by fft_input(), so the twiddle product is taken at
+*	full scale here to give X[k] / N like the complex transform.
+*/
+void fft_real_split(fft_complex_t *z, uint8_t log2m) {
+	const uint16_t m = 1 << log2m;
+	const uint16_t step = FFT_TABLE_N / (2 * m);
+
+	int16_t dc = z[0].re;
+	z[0].re = dc + z[0].im;
+	z[0].im = dc - z[0].im;
+
+	for (uint16_t k = 1; k <= m / 2; ++k) {
+		fft_complex_t& a = z[k];
+		fft_complex_t& b = z[m - k];
+
+		int16_t ere = (a.re >> 1) + (b.re >> 1);
+		int16_t eim = (a.im >> 1) - (b.im >> 1);
+		// O = -j * (Z[k] - conj(Z[M-k])) / 2
+		int16_t ore = (a.im >> 1) + (b.im >> 1);
+		int16_t oim = (b.re >> 1) - (a.re >> 1);
+
+		int16_t c, s;
+		fft_twiddle(k * step, c, s);
+		int16_t pre = (int16_t)(((int32_t)ore * c + (int32_t)oim * s) >> 15);
+		int16_t pim = (int16_t)(((int32_t)oim * c - (int32_t)ore * s) >> 15);
+
+		a.re = ere + pre;
+		a.im = eim + pim;
+		b.re = ere - pre;
+		b.im = pim - eim;
+	}
+}
+
+void fft_execute() {
+	#if FFT_RADIX == 4
+	fft_radix4(fft_work, FFT_CPLX_LOG2N);
+	#else
+	fft_radix2(fft_work, FFT_CPLX_LOG2N);
+	#endif
+
+	#if FFT_REAL
+	fft_real_split(fft_work, FFT_CPLX_LOG2N);
+	#endif
+}
+
+/*
+*	The leading one is found a byte at a time and then a bit at a time, so
+*	at most 7 single bit shifts of x are needed on AVR.
+*/
+uint16_t fft_log2(uint32_t x) {
+	if (!x) return 0;
+
+	uint8_t e = 31;
+	while (!(x & 0xff000000)) {
+		x <<= 8;
+		e -= 8;
+	}
+	while (!(x & 0x80000000)) {
+		x <<= 1;
+		--e;
+	}
+
+	uint8_t f = (uint8_t)(x >> (31 - FFT_LOG2_BITS)) & ((1 << FFT_LOG2_BITS) - 1);
+	return ((uint16_t)e << 8) | pgm_read_byte(&fft_log2_table[f]);
+}
+
+uint16_t fft_isqrt(uint32_t x) {
+	uint32_t root = 0;
+	uint32_t bit = (uint32_t)1 << 30;
+
+	while (bit > x) bit >>= 2;
+	while (bit) {
+		if (x >= root + bit) {
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t)root;
+}
+
+/*
+*	The level is log2 in Q4, taken from the Q8 fft_log2(). |X| is at most
+*	sqrt(2) * 2^15, so the level is at most 16 * 15.5 = 248 and always fits
+*	a byte.
+*/
+void fft_output() {
+	for (uint8_t k = 0; k < FFT_BINS; ++k) {
+		const fft_complex_t& x = fft_work[k];
+		int16_t im = x.im;
+		#if FFT_REAL
+		// The imaginary part of bin 0 is the Fs/2 bin.
+		if (k == 0) im = 0;
+		#endif
+
+		#if FFT_MAGNITUDE == FFT_MAGNITUDE_APPROX
+		// max(hi, 7/8 hi + 17/32 lo) with hi >= lo the larger and smaller of
+		// |re| and |im|.
+		uint16_t hi = x.re < 0 ? -(uint16_t)x.re : x.re;
+		uint16_t lo = im < 0 ? -(uint16_t)im : im;
+		if (lo > hi) {
+			uint16_t t = hi;
+			hi = lo;
+			lo = t;
+		}
+		uint16_t m = hi - (hi >> 3) + (lo >> 1) + (lo >> 5);
+		if (m < hi) m = hi;
+		uint16_t level = fft_log2(m) >> 4;
+		#else
+		uint32_t p = (uint32_t)((int32_t)x.re * x.re) + (uint32_t)((int32_t)im * im);
+		#if FFT_MAGNITUDE == FFT_MAGNITUDE_SQUARED
+		// Half the log2 of the power is the log2 of the magnitude.
+		uint16_t level = fft_log2(p) >> 5;
+		#else
+		uint16_t level = fft_log2(fft_isqrt(p)) >> 4;
+		#endif
+		#endif
+
+		fft_levels[k] = (uint8_t)level;
+	}
+}
@@ -0,0 +1,123 @@
+#include "include/fft_butterfly.h"
+
+#if FFT_SELFTEST
+#include <Arduino.h>
+
+#include "include/arena.h"
+#endif
+
+/*
+*	C reference for fft_butterflies_asm(). Any change here must be mirrored
+*	there, the two are expected to produce bit-identical output.
+*/
+extern "C" void fft_butterflies_c(fft_complex_t *x, uint16_t h,
+		uint16_t count, int16_t c, int16_t s) {
+	for (; count; --count, x += 2 * h) {
+		fft_complex_t& a = x[0];
+		fft_complex_t& b = x[h];
+
+		// The product is taken at half scale (>> 16 rather than >> 15), which
+		// is the 1/2 the butterfly applies anyway.
+		int16_t tre = (int16_t)(((int32_t)b.re * c + (int32_t)b.im * s) >> 16);
+		int16_t tim = (int16_t)(((int32_t)b.im * c - (int32_t)b.re * s) >> 16);
+
+		int16_t are = a.re >> 1;
+		int16_t aim = a.im >> 1;
+		a.re = are + tre;
+		a.im = aim + tim;
+		b.re = are - tre;
+		b.im = aim - tim;
+	}
+}
+
+#if FFT_SELFTEST
+#define FFT_SELFTEST_RUNS 16
+
+static uint16_t fft_selftest_seed = 0xace1;
+
+// 16 bit xorshift, never 0.
+static int16_t fft_selftest_random() {
+	uint16_t x = fft_selftest_seed;
+	x ^= x << 7;
+	x ^= x >> 9;
+	x ^= x << 8;
+	fft_selftest_seed = x;
+	return (int16_t)x;
+}
+
+// Twiddle factors stay within +-32767, like those of the FFT tables, so
+// c b.re + s b.im can not overflow 32 bits.
+static int16_t fft_selftest_twiddle() {
+	int16_t v = fft_selftest_random();
+	return v == INT16_MIN ? INT16_MIN + 1 : v;
+}
+
+typedef void (*fft_kernel_t)(fft_complex_t *, uint16_t, uint16_t, int16_t,
+		int16_t);
+
+/*
+*	Timer1 counts CPU cycles with interrupts disabled for the duration of a
+*	call, well under its 65536 cycles per run.
+*/
+static uint16_t fft_selftest_time(fft_kernel_t kernel, fft_complex_t *x,
+		uint16_t h, uint16_t count, int16_t c, int16_t s) {
+	uint8_t sreg = SREG;
+	cli();
+	TCNT1 = 0;
+	kernel(x, h, count, c, s);
+	uint16_t cycles = TCNT1;
+	SREG = sreg;
+	return cycles;
+}
+
+bool fft_selftest() {
+	// Both engines start after this, so their state is not in use yet.
+	fft_complex_t *ref = arena.spectral.selftest.ref;
+	fft_complex_t *out = arena.spectral.selftest.out;
+
+	uint8_t tccr1a = TCCR1A;
+	uint8_t tccr1b = TCCR1B;
+	uint8_t timsk1 = TIMSK1;
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+	TIMSK1 = 0;
+
+	uint32_t cycles_c = 0;
+	uint32_t cycles_asm = 0;
+	bool match = true;
+	for (uint8_t run = 0; run < FFT_SELFTEST_RUNS; ++run) {
+		uint16_t h = 1 + (run & 1);
+		uint16_t count = FFT_SELFTEST_N / (2 * h);
+		int16_t c = fft_selftest_twiddle();
+		int16_t s = fft_selftest_twiddle();
+		for (uint8_t i = 0; i < FFT_SELFTEST_N; ++i) {
+			ref[i].re = out[i].re = fft_selftest_random();
+			ref[i].im = out[i].im = fft_selftest_random();
+		}
+
+		cycles_c += fft_selftest_time(fft_butterflies_c, ref, h, count, c, s);
+		cycles_asm += fft_selftest_time(fft_butterflies_asm, out, h, count,
+				c, s);
+		for (uint8_t i = 0; i < FFT_SELFTEST_N; ++i) {
+			if (ref[i].re != out[i].re || ref[i].im != out[i].im) match = false;
+		}
+	}
+
+	TCCR1A = tccr1a;
+	TCCR1B = tccr1b;
+	TIMSK1 = timsk1;
+
+	// Cycles per butterfly, the call included. Every run has
+	// FFT_SELFTEST_N / 2 butterflies.
+	const uint16_t n = FFT_SELFTEST_RUNS * FFT_SELFTEST_N / 2;
+	Serial.begin(FFT_SELFTEST_BAUD);
+	Serial.print(F("butterfly c "));
+	Serial.print(cycles_c / n);
+	Serial.print(F(" asm "));
+	Serial.print(cycles_asm / n);
+	Serial.println(match ? F(" cycles, match") : F(" cycles, MISMATCH"));
+	Serial.flush();
+	Serial.end();
+	return match;
+}
+#endif
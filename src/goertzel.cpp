@@ -0,0 +1,65 @@
+#include <math.h>
+
+#include "include/goertzel.h"
+
+uint8_t goertzel_blocks;
+
+/*
+*	This runs once at startup (and whenever the sample rate changes), so it
+*	uses floating point rather than another table.
+*/
+void goertzel_init(uint32_t fs) {
+	for (uint8_t b = 0; b < goertzel_bands; ++b) {
+		goertzel_band_t& g = goertzel_state[b];
+		uint16_t f = pgm_read_word(&goertzel_frequencies[b]);
+
+		if (2 * (uint32_t)f >= fs) {
+			g.coeff = 0;
+		} else {
+			double c = 2 * cos(2 * M_PI * f / fs) * (1UL << GOERTZEL_COEFF_BITS);
+			g.coeff = c > INT32_MAX ? INT32_MAX : (int32_t)lround(c);
+		}
+		g.s1 = 0;
+		g.s2 = 0;
+		goertzel_levels[b] = 0;
+	}
+	goertzel_blocks = 0;
+}
+
+/*
+*	|X|^2 = s1^2 + s2^2 - 2 cos(w) s1 s2. For low bands the states are much
+*	larger than |X| and the terms nearly cancel, so this is evaluated once
+*	per band in 64 bits. The result is shifted down to 32 bits for
+*	fft_log2() and the shift is added back in the log domain, where |X| is
+*	also normalized by GOERTZEL_N and the input shift to the X[k] / N scale
+*	of the FFT.
+*/
+void goertzel_output() {
+	for (uint8_t b = 0; b < goertzel_bands; ++b) {
+		goertzel_band_t& g = goertzel_state[b];
+		int64_t s1 = g.s1;
+		int64_t s2 = g.s2;
+		g.s1 = 0;
+		g.s2 = 0;
+
+		if (!g.coeff) continue;
+
+		int64_t p = s1 * s1 + s2 * s2
+				- ((g.coeff * s1) >> GOERTZEL_COEFF_BITS) * s2;
+		if (p <= 0) {
+			goertzel_levels[b] = 0;
+			continue;
+		}
+
+		// Shift by an even amount so that half of it is whole bits of |X|.
+		int8_t e = goertzel_shift - GOERTZEL_LOG2N;
+		while (p >> 32) {
+			p >>= 2;
+			++e;
+		}
+
+		// 16 * (log2(p) / 2 + e), with log2 in Q8 from fft_log2().
+		int16_t level = (int16_t)(fft_log2((uint32_t)p) >> 5) + 16 * e;
+		goertzel_levels[b] = level < 0 ? 0 : level > 255 ? 255 : (uint8_t)level;
+	}
+}
@@ -0,0 +1,52 @@
+#include <Arduino.h>
+
+#include "include/mode.h"
+
+uint8_t mode_current;
+static mode_state_t mode_state;
+
+void mode_init() {
+	#if MODE_BUTTON
+	MODE_PORT |= _BV(MODE_BIT);
+	#endif
+}
+
+void mode_request(uint8_t m) {
+	if (m < MODE_COUNT) mode_state.pending = m;
+}
+
+/*
+*	The button is sampled once per frame. A press is the first frame it reads
+*	low once it has been in the same state for MODE_DEBOUNCE_MS.
+*/
+void mode_poll() {
+	#if MODE_BUTTON
+	bool down = !(MODE_PIN & _BV(MODE_BIT));
+	uint16_t now = (uint16_t)millis();
+	if (down != mode_state.last) {
+		mode_state.last = down;
+		mode_state.since = now;
+	} else if (down != mode_state.pressed
+			&& (uint16_t)(now - mode_state.since) >= MODE_DEBOUNCE_MS) {
+		mode_state.pressed = down;
+		if (mode_state.pressed) {
+			uint8_t next = mode_state.pending + 1;
+			mode_request(next < MODE_COUNT ? next : 0);
+		}
+	}
+	#endif
+
+	#if MODE_SERIAL
+	while (Serial.available()) {
+		int c = Serial.read();
+		if (c >= '0' && c <= '9') mode_request(c - '0');
+	}
+	#endif
+}
+
+bool mode_update() {
+	uint8_t m = mode_state.pending;
+	if (m == mode_current) return false;
+	mode_current = m;
+	return true;
+}
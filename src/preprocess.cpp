@@ -0,0 +1,39 @@
+#include "include/hal.h"
+#include "include/preprocess.h"
+#include "include/drc_table.h"
+
+preprocess_state_t preprocess_state[ADC_CHANNELS] = {
+	{
+		0,
+		0,
+		1 << PREPROCESS_DRC_GAIN_BITS,
+	},
+	#if ADC_CHANNELS > 1
+	{ 0, 0, 1 << PREPROCESS_DRC_GAIN_BITS },
+	#endif
+	#if ADC_CHANNELS > 2
+	{ 0, 0, 1 << PREPROCESS_DRC_GAIN_BITS },
+	#endif
+	#if ADC_CHANNELS > 3
+	{ 0, 0, 1 << PREPROCESS_DRC_GAIN_BITS },
+	#endif
+};
+
+void preprocess_update(preprocess_state_t& st, int32_t sum, uint16_t peak,
+		uint8_t log2n) {
+	// The mean of the Q15 samples is again Q15.
+	if (PREPROCESS_DC_SHIFT) {
+		int16_t mean = (int16_t)(sum >> log2n);
+		st.dc += (mean - st.dc) >> PREPROCESS_DC_SHIFT;
+	}
+
+	if (peak >= st.envelope) st.envelope = peak;
+	else st.envelope -= (st.envelope - peak) >> PREPROCESS_RELEASE_SHIFT;
+
+	if (PREPROCESS_DRC) {
+		// The envelope is at most 2^15, the top entry covers full scale.
+		uint8_t k = st.envelope >> (15 - PREPROCESS_DRC_LOG2_ENTRIES);
+		if (k >= PREPROCESS_DRC_ENTRIES) k = PREPROCESS_DRC_ENTRIES - 1;
+		st.gain = pgm_read_word(&preprocess_drc_table[k]);
+	}
+}
@@ -0,0 +1,141 @@
+#include <Arduino.h>
+
+#include "include/profile.h"
+#include "include/telemetry.h"
+
+#if PROFILE_GPIO
+void profile_gpio_init() {
+	PROFILE_DDR |= _BV(PROFILE_BIT);
+}
+#endif
+
+#if PROFILE
+
+profile_stat_t profile_stats[PROFILE_STAGES];
+
+volatile uint16_t profile_overflows;
+uint32_t profile_start[PROFILE_STAGES];
+uint16_t profile_overhead;
+
+// Telemetry sends the stage numbers, tools/telemetry_plot.py has the names.
+#if !TELEMETRY
+static const char profile_name_preprocess[] PROGMEM = "preprocess";
+static const char profile_name_fft_input[] PROGMEM = "fft_input";
+static const char profile_name_fft_execute[] PROGMEM = "fft_execute";
+static const char profile_name_fft_output[] PROGMEM = "fft_output";
+static const char profile_name_output[] PROGMEM = "output";
+static const char profile_name_goertzel[] PROGMEM = "goertzel";
+static const char profile_name_bands[] PROGMEM = "bands";
+static const char profile_name_fade[] PROGMEM = "fade";
+static const char profile_name_color[] PROGMEM = "color";
+
+static const char *const profile_names[PROFILE_STAGES] PROGMEM = {
+	profile_name_preprocess,
+	profile_name_fft_input,
+	profile_name_fft_execute,
+	profile_name_fft_output,
+	profile_name_output,
+	profile_name_goertzel,
+	profile_name_bands,
+	profile_name_fade,
+	profile_name_color,
+};
+#endif
+
+ISR(TIMER1_OVF_vect) {
+	++profile_overflows;
+}
+
+static void profile_reset() {
+	for (uint8_t i = 0; i < PROFILE_STAGES; ++i) {
+		profile_stats[i].min = UINT32_MAX;
+		profile_stats[i].max = 0;
+		profile_stats[i].sum = 0;
+		profile_stats[i].count = 0;
+	}
+}
+
+void profile_init() {
+	// Normal mode, no prescaling, overflow interrupt extends the count.
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+	TCNT1 = 0;
+	TIFR1 = _BV(TOV1);
+	TIMSK1 = _BV(TOIE1);
+
+	// Time an empty stage, which is the cost of the measurement itself.
+	profile_overhead = 0;
+	profile_reset();
+	profile_begin(0);
+	profile_end(0);
+	profile_overhead = (uint16_t)profile_stats[0].min;
+	profile_reset();
+}
+
+/*
+*	If the timer overflowed but the interrupt has not been serviced yet (the
+*	caller may have interrupts disabled), a small TCNT1 belongs to the next
+*	overflow period.
+*/
+uint32_t profile_cycles() {
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t lo = TCNT1;
+	uint16_t hi = profile_overflows;
+	if ((TIFR1 & _BV(TOV1)) && lo < 0x8000) ++hi;
+	SREG = sreg;
+
+	return ((uint32_t)hi << 16) | lo;
+}
+
+void profile_begin(uint8_t stage) {
+	profile_start[stage] = profile_cycles();
+}
+
+void profile_end(uint8_t stage) {
+	uint32_t cycles = profile_cycles() - profile_start[stage];
+	cycles = cycles > profile_overhead ? cycles - profile_overhead : 0;
+
+	profile_stat_t& stat = profile_stats[stage];
+	if (cycles < stat.min) stat.min = cycles;
+	if (cycles > stat.max) stat.max = cycles;
+	stat.sum += cycles;
+	++stat.count;
+}
+
+#if TELEMETRY
+// The dropped frames are part of the telemetry status.
+void profile_report(uint16_t) {
+	for (uint8_t i = 0; i < PROFILE_STAGES; ++i) {
+		if (profile_stats[i].count) telemetry_profile(i, profile_stats[i]);
+	}
+
+	profile_reset();
+}
+#else
+/*
+*	Printing blocks once the Serial TX buffer is full, so frames captured
+*	while reporting may show up as dropped in the next report.
+*/
+void profile_report(uint16_t dropped) {
+	Serial.print(F("dropped "));
+	Serial.println(dropped);
+
+	for (uint8_t i = 0; i < PROFILE_STAGES; ++i) {
+		const profile_stat_t& stat = profile_stats[i];
+		if (!stat.count) continue;
+
+		Serial.print((const __FlashStringHelper *)pgm_read_ptr(&profile_names[i]));
+		Serial.print(F(" min "));
+		Serial.print(stat.min);
+		Serial.print(F(" max "));
+		Serial.print(stat.max);
+		Serial.print(F(" mean "));
+		Serial.println(stat.sum / stat.count);
+	}
+
+	profile_reset();
+}
+#endif
+
+#endif
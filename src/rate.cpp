@@ -0,0 +1,64 @@
+#include <Arduino.h>
+
+#include "include/fft.h"
+#include "include/rate.h"
+
+#if RATE_ADAPT
+
+uint8_t rate_step = adc_adps(ADC_PRESCALER) - adc_adps(RATE_MIN_PRESCALER);
+
+static rate_state_t rate_state;
+
+// Microseconds to capture a frame at step s.
+static uint32_t rate_period_us(uint8_t s) {
+	return (uint32_t)FFT_N * 13 * ADC_CHANNELS * ADC_OVERSAMPLE
+			* (RATE_MIN_PRESCALER << s) / (F_CPU / 1000000UL);
+}
+
+void rate_restart() {
+	rate_state.busy_start = micros();
+	rate_state.busy_max = 0;
+	rate_state.frames = 0;
+}
+
+void rate_wait_begin() {
+	uint32_t busy = micros() - rate_state.busy_start;
+	if (busy > rate_state.busy_max) rate_state.busy_max = busy;
+}
+
+void rate_wait_end() {
+	rate_state.busy_start = micros();
+}
+
+/*
+*	The thresholds are compared as busy * 100 against percent * period, so
+*	there is no division per decision.
+*/
+bool rate_update(uint16_t dropped) {
+	if (++rate_state.frames < RATE_WINDOW) return false;
+
+	uint32_t busy = rate_state.busy_max * 100;
+	uint32_t period = rate_period_us(rate_step);
+	bool overrun = dropped != rate_state.dropped;
+	uint8_t step = rate_step;
+
+	rate_state.frames = 0;
+	rate_state.busy_max = 0;
+	rate_state.dropped = dropped;
+
+	if (overrun || busy > RATE_HIGH * period) {
+		if (step + 1 < rate_steps) ++step;
+	} else if (busy < RATE_LOW * period) {
+		if (step) --step;
+	}
+	if (step == rate_step) return false;
+
+	rate_step = step;
+	// ADIF is cleared by writing a one, so keep it out of the write back or a
+	// pending conversion interrupt is lost.
+	ADCSRA = (ADCSRA & ~(_BV(ADIF) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0)))
+			| (adc_adps(RATE_MIN_PRESCALER) + step);
+	return true;
+}
+
+#endif
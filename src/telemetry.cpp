@@ -0,0 +1,133 @@
+#include <Arduino.h>
+#include <util/crc16.h>
+#include <wiring_private.h>
+
+#include "include/hal.h"
+#include "include/mode.h"
+#include "include/rate.h"
+#include "include/telemetry.h"
+
+#if TELEMETRY
+
+uint8_t telemetry_buffer[TELEMETRY_BUFFER];
+
+static telemetry_state_t telemetry;
+
+static inline uint8_t telemetry_next(uint8_t i) {
+	return (i + 1) & (TELEMETRY_BUFFER - 1);
+}
+
+void telemetry_init() {
+	UBRR0 = telemetry_ubrr;
+	UCSR0A = _BV(U2X0);
+	UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);		// 8N1
+	UCSR0B = _BV(TXEN0);
+}
+
+ISR(USART_UDRE_vect) {
+	uint8_t tail = telemetry.tail;
+	if (tail == telemetry.head) {
+		cbi(UCSR0B, UDRIE0);
+		return;
+	}
+	UDR0 = telemetry_buffer[tail];
+	telemetry.tail = telemetry_next(tail);
+}
+
+/*
+*	A zero ends the current COBS block and so does a block of 254 non-zero
+*	bytes, which has no implied zero after it.
+*/
+static void telemetry_cobs(uint8_t b) {
+	if (b) {
+		telemetry_buffer[telemetry.pos] = b;
+		telemetry.pos = telemetry_next(telemetry.pos);
+		if (++telemetry.run != 0xff) return;
+	}
+	telemetry_buffer[telemetry.code] = telemetry.run;
+	telemetry.code = telemetry.pos;
+	telemetry.pos = telemetry_next(telemetry.pos);
+	telemetry.run = 1;
+}
+
+static void telemetry_put(uint8_t b) {
+	telemetry.crc = _crc8_ccitt_update(telemetry.crc, b);
+	telemetry_cobs(b);
+}
+
+static void telemetry_put16(uint16_t v) {
+	telemetry_put((uint8_t)v);
+	telemetry_put((uint8_t)(v >> 8));
+}
+
+static void telemetry_put32(uint32_t v) {
+	telemetry_put16((uint16_t)v);
+	telemetry_put16((uint16_t)(v >> 16));
+}
+
+/*
+*	Start a message of type with a payload of n bytes if it fits whole.
+*	Encoded, type, sequence, payload and CRC take n + 3 bytes, plus a code
+*	byte per 254 of them and the terminating zero.
+*/
+static bool telemetry_begin(uint8_t type, uint16_t n) {
+	uint8_t head = telemetry.head;
+	uint8_t used = (head - telemetry.tail) & (TELEMETRY_BUFFER - 1);
+	uint16_t size = n + 3 + (n + 3) / 254 + 2;
+	if (used + size >= TELEMETRY_BUFFER) {
+		++telemetry.lost;
+		return false;
+	}
+
+	telemetry.code = head;
+	telemetry.pos = telemetry_next(head);
+	telemetry.run = 1;
+	telemetry.crc = 0;
+	telemetry_put(type);
+	telemetry_put(telemetry.seq++);
+	return true;
+}
+
+static void telemetry_end() {
+	telemetry_cobs(telemetry.crc);
+	telemetry_buffer[telemetry.code] = telemetry.run;
+	telemetry_buffer[telemetry.pos] = 0;
+
+	HAL_BARRIER();
+	telemetry.head = telemetry_next(telemetry.pos);
+	sbi(UCSR0B, UDRIE0);
+}
+
+void telemetry_levels(const uint8_t *levels, uint8_t n, uint8_t first) {
+	if (!telemetry_begin(TELEMETRY_LEVELS, n + 2)) return;
+	telemetry_put(first);
+	telemetry_put(n);
+	for (uint8_t i = 0; i < n; ++i) telemetry_put(levels[i]);
+	telemetry_end();
+}
+
+void telemetry_frame(uint16_t dropped) {
+	if (++telemetry.frames < TELEMETRY_STATUS_FRAMES) return;
+	telemetry.frames = 0;
+
+	if (!telemetry_begin(TELEMETRY_STATUS, 7)) return;
+	telemetry_put16(dropped);
+	telemetry_put16(telemetry.lost);
+	telemetry_put(mode_current);
+	telemetry_put16(rate_prescaler());
+	telemetry_end();
+}
+
+#if PROFILE
+void telemetry_profile(uint8_t stage, const profile_stat_t& stat) {
+	if (!telemetry_begin(TELEMETRY_PROFILE, 15)) return;
+	telemetry_put(stage);
+	telemetry_put16(stat.count);
+	telemetry_put32(stat.min);
+	telemetry_put32(stat.max);
+	telemetry_put32(stat.sum / stat.count);
+	telemetry_end();
+}
+#endif
+
+#endif
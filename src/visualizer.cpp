@@ -39,57 +39,268 @@
 * G) 	Output the visualization.
 */
 
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include <wiring_private.h>
+
+#include "include/AdcConfig.h"
+#include "include/apa102.h"
+#include "include/arena.h"
+#include "include/capture.h"
 #include "include/CircularBuffer.h"
+#include "include/fft_butterfly.h"
+#include "include/FrameQueue.h"
+#include "include/mode.h"
+#include "include/Pipeline.h"
+#include "include/profile.h"
+#include "include/rate.h"
+#include "include/stages.h"
+#include "include/telemetry.h"
+#include "include/ws2812.h"
+
+#define ADC_PIN 0
+
+// Capture strategy CAPTURE_MODE, see include/capture.h.
+
+// Number of capture buffers queued between the ISR and loop() in
+// CAPTURE_ISR mode. 2 is ping/pong, 3 lets a complete frame wait while the
+// previous one is still being processed. A frame holds a buffer per ADC
+// channel, so with several channels only ping/pong fits by default.
+#ifndef CAPTURE_FRAMES
+#define CAPTURE_FRAMES (ADC_CHANNELS > 1 ? 2 : 3)
+#endif
+
+// Samples between the starts of two frames in CAPTURE_OVERLAP mode, a power
+// of two. FFT_N / 2 is 50% overlap, FFT_N / 4 is 75%.
+#ifndef CAPTURE_HOP
+#define CAPTURE_HOP (FFT_N / 2)
+#endif
+
+// Use the hand written ISR_NAKED capture handler instead of the compiled one.
+// This bypasses CircularBuffer::write(), the capture buffers are only used as
+// storage, filled in order from data().
+#ifndef ADC_ISR_NAKED
+#define ADC_ISR_NAKED 0
+#endif
+
+// Spectral engine.
+//	SPECTRUM_FFT		Full FFT_N point transform, FFT_BINS levels in
+//						fft_levels[].
+//	SPECTRUM_GOERTZEL	One Goertzel filter per band center, levels in
+//						goertzel_levels[], see include/goertzel.h.
+#define SPECTRUM_FFT		0
+#define SPECTRUM_GOERTZEL	1
+
+#ifndef SPECTRUM_ENGINE
+#define SPECTRUM_ENGINE SPECTRUM_FFT
+#endif
+
+// LED frames per second. Fading runs at this rate, timed by millis(),
+// whatever the rate of spectrum frames. With CAPTURE_POLL millis() stalls
+// during capture, so LED frames are stretched by up to a capture.
+#ifndef LED_FPS
+#define LED_FPS 60
+#endif
+
+// F.iv. Layout and movement of the strip.
+//	LED_EFFECT_CHANNELS	LED_COUNT / FADE_CHANNELS pixels per channel, only
+//						changed channels are drawn.
+//	LED_EFFECT_SCROLL	Every LED frame the strip moves up by a pixel and the
+//						loudest channel enters at the start.
+#define LED_EFFECT_CHANNELS	0
+#define LED_EFFECT_SCROLL	1
 
-#define ADC_PRESCALER 16
-
-/* 	REFERENCES
-*	www.openmusiclabs.com/learning/digital/atmega-adc/
-*	www.openmusiclabs.com/learning/digital/atmega-adc/in-depth/
-*
-*   | ADC Pre | ADC Clk | # of |          |          |
-*   | -scalar | F (kHz) | Bits | Fs (kHz) | Fn (kHz) |
-*   |---------|---------|------|----------|----------|
-*   |   128   |    125  |  9.6 |    9.62  |    4.81  |
-*   |    64   |    250  |  9.5 |   19.23  |    9.62  |
-*   |    32   |    500  |  9.4 |   38.46  |   19.23  |
-*   |    16   |   1000  |  8.7 |   76.92  |   38.46  |
-*   |     8   |   2000  |  7.4 |  153.85  |   76.92  |
-*   |     4   |   4000  |  5.9 |  307.69  |  153.85  |
-*   |     2   |    N/A  |  N/A |  615.38  |  307.69  |
+#ifndef LED_EFFECT
+#define LED_EFFECT LED_EFFECT_CHANNELS
+#endif
+
+#ifndef LED_COUNT
+#define LED_COUNT FADE_CHANNELS
+#endif
+
+// Pixels per dirty segment of the framebuffer, must divide LED_COUNT.
+#ifndef LED_SEGMENT
+#define LED_SEGMENT 4
+#endif
+
+#if LED_EFFECT != LED_EFFECT_CHANNELS && LED_EFFECT != LED_EFFECT_SCROLL
+#error LED_EFFECT must be one of the LED_EFFECT_* effects.
+#endif
+
+// Switch the spectral engine and the LED effect at runtime, see
+// include/mode.h. SPECTRUM_ENGINE and LED_EFFECT then select the mode at
+// startup.
+#ifndef MODE_SWITCH
+#define MODE_SWITCH (CAPTURE_MODE != CAPTURE_OVERLAP && ADC_CHANNELS == 1)
+#endif
+
+/*
+*	With ADC_CHANNELS > 1 the ISR steps ADMUX through ADC_PIN..ADC_PIN +
+*	ADC_CHANNELS - 1 and a frame holds FFT_N samples of each, see
+*	capture_frame_t. The Goertzel filters keep the state of a single
+*	stream, so the channels need the FFT.
 */
-#if ADC_PRESCALAR == 128
-	#define ADC_BITS 9
-#elif ADC_PRESCALAR == 64
-	#define ADC_BITS 9
-#elif ADC_PRESCALAR == 32
-	#define ADC_BITS 9
-#elif ADC_PRESCALAR == 16
-	#define ADC_BITS 8
-#elif ADC_PRESCALAR == 8
-	#define ADC_BITS 7
-#elif ADC_PRESCALAR == 4
-	#define ADC_BITS 5
+#if ADC_CHANNELS > 1
+#if CAPTURE_MODE != CAPTURE_ISR || ADC_ISR_NAKED
+#error ADC_CHANNELS > 1 needs CAPTURE_ISR without ADC_ISR_NAKED
+#endif
+#if MODE_SWITCH || SPECTRUM_ENGINE != SPECTRUM_FFT
+#error ADC_CHANNELS > 1 needs SPECTRUM_FFT without MODE_SWITCH
+#endif
+#endif
+
+// Oversampling sums the readings of a single input in the compiled
+// handlers, see adc_read().
+#if ADC_OVERSAMPLE > 1 && (ADC_CHANNELS > 1 || ADC_ISR_NAKED)
+#error ADC_OVERSAMPLE needs a single ADC channel and no ADC_ISR_NAKED
+#endif
+
+// The rate controller of include/rate.h measures the wait for a queued frame.
+#if RATE_ADAPT && CAPTURE_MODE != CAPTURE_ISR
+#error RATE_ADAPT needs CAPTURE_ISR
+#endif
+
+// ADC0..ADC5 are the analog pins with a digital input buffer in DIDR0.
+static_assert(ADC_PIN + ADC_CHANNELS <= 6, "ADC_CHANNELS pins from ADC_PIN");
+
+// Output backend.
+//	OUTPUT_NONE		Nothing is output, e.g. while profiling over Serial.
+//	OUTPUT_WS2812	A WS2812 strip on TXD, written by the USART in master SPI
+//					mode with interrupts enabled, see include/ws2812.h.
+//	OUTPUT_APA102	An APA102 strip on the SPI, streamed by the SPI interrupt
+//					while the next frame is drawn, see include/apa102.h.
+#define OUTPUT_NONE		0
+#define OUTPUT_WS2812	1
+#define OUTPUT_APA102	2
+
+#ifndef OUTPUT_MODE
+#if PROFILE
+#define OUTPUT_MODE OUTPUT_NONE
 #else
-	#error Prescalar must be one of {4, 8, 16, 32, 64, 128}.
+#define OUTPUT_MODE OUTPUT_WS2812
+#endif
 #endif
 
-// Optionally override ADC_BITS to be <= 8 to use a single byte even if this
-// means discarding some information from the ADC.
-// #define ADC_BITS 8
+#if TELEMETRY
+#if OUTPUT_MODE == OUTPUT_WS2812
+#error OUTPUT_WS2812 uses the USART, which TELEMETRY needs
+#endif
+#if MODE_SWITCH && MODE_SERIAL
+#error MODE_SERIAL needs Serial, which can not share the USART with TELEMETRY
+#endif
+#if FFT_SELFTEST
+#error FFT_SELFTEST needs Serial, which can not share the USART with TELEMETRY
+#endif
+#endif
 
-#if ADC_BITS > 8
-typedef uint16_t adc_data_t;
-#elif
-typedef uint8_t adc_data_t;
+#if OUTPUT_MODE == OUTPUT_WS2812
+#if PROFILE
+#error OUTPUT_WS2812 uses the USART, which PROFILE needs for Serial
+#endif
+// A frame and the latch after it fit between two LED frames.
+static_assert(36UL * LED_COUNT + 300 < 1000000UL / LED_FPS,
+		"LED_FPS is too high for the number of pixels");
+#if MODE_SWITCH && MODE_SERIAL
+#error MODE_SERIAL needs the USART, which OUTPUT_WS2812 uses
+#endif
+#elif OUTPUT_MODE == OUTPUT_APA102
+#if PROFILE_GPIO
+#error OUTPUT_APA102 makes PROFILE_PIN (MISO) an input
+#endif
+// A frame, start and end frames included, streams between two LED frames.
+static_assert(8UL * APA102_SPI_DIVIDER * (4 * LED_COUNT + 8 + LED_COUNT / 16)
+		/ (F_CPU / 1000000) < 1000000UL / LED_FPS,
+		"LED_FPS is too high for the number of pixels");
+#elif OUTPUT_MODE != OUTPUT_NONE
+#error OUTPUT_MODE must be one of the OUTPUT_* backends.
 #endif
 
-#define ADC_PIN 0
+static_assert(goertzel_bands <= FADE_CHANNELS, "a band per fade channel");
+static_assert(BANDS_COUNT <= FADE_CHANNELS, "a band per fade channel");
+
+// Raw ADC readings are stored widened to fft_sample_t so the FFT can run in
+// the buffer once it is handed to processing, see fft_input(). Each capture
+// buffer doubles as the FFT work array.
+typedef CircularBuffer<fft_sample_t, FFT_N> capture_buffer_t;
+
+#if CAPTURE_MODE == CAPTURE_POLL
+capture_buffer_t frame;
+#elif CAPTURE_MODE == CAPTURE_OVERLAP
+// A frame stays intact for FFT_N samples after it ended, which is how long
+// loop() has to read it.
+typedef CircularBuffer<fft_sample_t, 2 * FFT_N> capture_ring_t;
+capture_ring_t ring;
+
+// Hops completed by the ISR and consumed by loop(), modulo 256. Only the
+// ISR writes ring_hops and it is a single byte, so no locking is needed.
+volatile uint8_t ring_hops;
+uint8_t ring_hops_done;
+uint16_t ring_dropped;
+
+static_assert((CAPTURE_HOP & (CAPTURE_HOP - 1)) == 0 && CAPTURE_HOP <= FFT_N,
+		"CAPTURE_HOP must be a power of two no larger than FFT_N");
+static_assert(2 * FFT_N / CAPTURE_HOP <= 256,
+		"the hop count must wrap with the ring");
+
+#if ADC_ISR_NAKED
+#error ADC_ISR_NAKED only supports CAPTURE_ISR
+#endif
+
+// Ring index at the end of hop h, which is also where hop h + 1 starts.
+inline capture_ring_t::index_t ring_hop_end(uint8_t h) {
+	return ((uint16_t)h * CAPTURE_HOP) & (2 * FFT_N - 1);
+}
+#elif ADC_CHANNELS > 1
+// The buffers of all channels are filled together and queued as one frame.
+struct capture_frame_t {
+	capture_buffer_t channel[ADC_CHANNELS];
+
+	void clear() {
+		for (uint8_t c = 0; c < ADC_CHANNELS; ++c) channel[c].clear();
+	}
+};
+
+FrameQueue<capture_frame_t, CAPTURE_FRAMES> frames;
+
+// Channel of the conversion that completes next.
+uint8_t capt_channel;
+#else
+FrameQueue<capture_buffer_t, CAPTURE_FRAMES> frames;
+#endif
+
+#if ADC_OVERSAMPLE > 1
+// Sum of the readings of the sample being decimated and their count.
+uint16_t capt_sum;
+uint8_t capt_count;
+#endif
 
-volatile bool buf_full;
-volatile CircularBuffer ping(BUFF_SIZE);
-volatile CircularBuffer pong(BUFF_SIZE);
-volatile CircularBuffer *capt_buf, *proc_buf;
+/*
+*	Read the conversion that just completed into s. Returns false while
+*	the readings of an oversampled sample are still being summed, every
+*	ADC_OVERSAMPLE readings their sum is stored as a Q15 sample.
+*
+*	Reading ADCL locks both ADCL and ADCH so they must be read in this
+*	order, and must both be read even if output is only 8 bits.
+*/
+inline bool adc_read(fft_sample_t& s) {
+	#if ADC_OVERSAMPLE > 1
+	capt_sum += ADC;
+	if (++capt_count & (ADC_OVERSAMPLE - 1)) return false;
+	s = adc_config::sum_q15(capt_sum);
+	capt_sum = 0;
+	#else
+	if (adc_config::left_adjust) s = ADCH;
+	else s = ADC;
+	#endif
+	return true;
+}
+
+#if CAPTURE_MODE == CAPTURE_ISR && ADC_ISR_NAKED
+// Next sample slot in frames.back() and the number of samples left to fill
+// it, modulo 256 so that a count of 0 means 256.
+fft_sample_t *capt_ptr;
+uint8_t capt_left;
+#endif
 
 /*
 *	Register a handler for the ADC conversion complete interrupt (ADC_vect).
@@ -106,38 +317,162 @@ volatile CircularBuffer *capt_buf, *proc_buf;
 *
 *	REFERENCE:	http://www.gammon.com.au/interrupts
 */
+#if CAPTURE_MODE == CAPTURE_POLL
+/*
+*	Fill buf with interrupts disabled by polling the conversion complete flag.
+*
+*	The ADC keeps free running, so the flag is cleared first to discard a
+*	conversion that completed while the previous buffer was being processed.
+*	ADIF is cleared by writing a one to it.
+*/
+void capture_poll(capture_buffer_t& buf) {
+	buf.clear();
+
+	cli();
+	sbi(ADCSRA, ADIF);
+	while (!buf.full()) {
+		while (!(ADCSRA & _BV(ADIF)));
+		sbi(ADCSRA, ADIF);
+
+		fft_sample_t s;
+		if (adc_read(s)) buf.write(s);
+	}
+	sei();
+}
+#elif ADC_ISR_NAKED
+/*
+*	Once per frame continuation of the naked handler below.
+*
+*	The naked handler jumps here with every register and SREG restored to
+*	their values on interrupt entry, so this runs as an ordinary compiled
+*	ISR and ends with reti. The __vector prefix keeps avr-gcc from flagging
+*	the signal attribute on a name that is not an interrupt vector.
+*/
+extern "C" void __vector_capture_frame(void) __attribute__((signal, used));
+
+void __vector_capture_frame(void) {
+	frames.push();
+	capt_ptr = frames.back().data();
+	capt_left = (uint8_t)FFT_N;
+}
+
+/*
+*	Naked version of the handler below.
+*
+*	Only r24, r30:r31 and SREG are saved. The sample is stored straight
+*	through capt_ptr and a byte countdown replaces CircularBuffer::full().
+*	When the buffer is full, the registers are restored and the frame is
+*	handed to __vector_capture_frame(), so the queue logic exists once, in
+*	C++.
+*
+*	Per sample this is about 50 cycles including interrupt entry and reti,
+*	against adc_config::cycles_per_sample (208 at ADC_PRESCALER 16).
+*/
+static_assert(FFT_N <= 256, "capt_left is a single byte");
+
+ISR(ADC_vect, ISR_NAKED) {
+	asm volatile(
+		"push	r24\n\t"
+		"in		r24, __SREG__\n\t"
+		"push	r24\n\t"
+		"push	r30\n\t"
+		"push	r31\n\t"
+
+		"lds	r30, capt_ptr\n\t"
+		"lds	r31, capt_ptr+1\n\t"
+		".if %[left_adjust]\n\t"
+		"lds	r24, %[adch]\n\t"
+		"st		Z+, r24\n\t"
+		"clr	r24\n\t"			// r1 is not guaranteed to be zero here
+		"st		Z+, r24\n\t"
+		".else\n\t"
+		"lds	r24, %[adcl]\n\t"
+		"st		Z+, r24\n\t"
+		"lds	r24, %[adch]\n\t"
+		"st		Z+, r24\n\t"
+		".endif\n\t"
+
+		"lds	r24, capt_left\n\t"
+		"dec	r24\n\t"
+		"sts	capt_left, r24\n\t"
+		"breq	1f\n\t"
+
+		"sts	capt_ptr, r30\n\t"
+		"sts	capt_ptr+1, r31\n\t"
+		"pop	r31\n\t"
+		"pop	r30\n\t"
+		"pop	r24\n\t"
+		"out	__SREG__, r24\n\t"
+		"pop	r24\n\t"
+		"reti\n\t"
+
+		// Buffer full.
+		"1:\n\t"
+		"pop	r31\n\t"
+		"pop	r30\n\t"
+		"pop	r24\n\t"
+		"out	__SREG__, r24\n\t"
+		"pop	r24\n\t"
+		"%~jmp	__vector_capture_frame\n\t"
+		:
+		: [left_adjust] "n" (adc_config::left_adjust),
+		  [adcl] "n" (_SFR_MEM_ADDR(ADCL)),
+		  [adch] "n" (_SFR_MEM_ADDR(ADCH))
+	);
+}
+#elif CAPTURE_MODE == CAPTURE_OVERLAP
+ISR(ADC_vect) {
+	fft_sample_t s;
+	if (!adc_read(s)) return;
+	ring.write(s);
+
+	// The ring is a whole number of hops, so a hop ends whenever the write
+	// index is a multiple of CAPTURE_HOP.
+	if (!(ring.head() & (CAPTURE_HOP - 1))) ++ring_hops;
+}
+#elif ADC_CHANNELS > 1
+/*
+*	In free running mode the next conversion has already started when this
+*	runs, on the input selected before it, so a new ADMUX only applies to
+*	the conversion after that. The mux is set two channels ahead, and
+*	init_adc() selects the second channel during the first conversion.
+*
+*	Every channel fills at the same rate, so the frame is complete when the
+*	buffer of the last one is full. Each channel is sampled at adc_config::fs,
+*	1 / ADC_CHANNELS of the conversion rate, and the ISR still has to fit
+*	adc_config::cycles_per_sample.
+*/
 ISR(ADC_vect) {
-	// Read in data from the ADC register.
-	//
-	// Reading ADCL locks both ADCL and ADCH so they must be read 
-	// in this order and must both be read even if output is only 8 bits.
+	uint8_t ch = capt_channel;
+	capture_buffer_t& buf = frames.back().channel[ch];
+	if (adc_config::left_adjust) buf.write(ADCH);
+	else buf.write(ADC);
+
+	uint8_t next = ch + 1 == ADC_CHANNELS ? 0 : ch + 1;
+	uint8_t after = next + 1 == ADC_CHANNELS ? 0 : next + 1;
+	ADMUX = (ADMUX & 0xf0) | (ADC_PIN + after);
+	capt_channel = next;
+
+	if (!next && buf.full()) frames.push();
+}
+#else
+ISR(ADC_vect) {
+	// Read in data from the ADC register, see adc_read().
 	//
 	// Optionally, some noise thresholding could be applied here, but for
 	// modularity the data is simply collected as is and preprocessing is
 	// applied later.
-	#if ADC_BITS > 8
-	capt_buf->write(ADC);
-	#else
-	capt_buf->write(ADCH);
-	#endif
-
-	// TODO	Relative occurence of full buffer and already processing 
-	// 		(this order) and not processing and not full (switch order). 
-	if (!processing && capt_buf->full()) {
-		// Set a flag so the other buffer continues to fill/overwrite and 
-		// doesn't start to process until this buffer is done.
-		// This flag also informs the main loop to start processing this buffer.
-		processing = true;
-
-		// TODO	Will the other buffer continuing to fill (meaning this ISR being
-		// 		called after every ADC conversion) interrupt the processing?
+	fft_sample_t s;
+	if (!adc_read(s)) return;
+	capture_buffer_t& buf = frames.back();
+	buf.write(s);
 
-		// Swap the collection and processing buffers.
-		CircularBuffer *tmp = proc_buf;
-		proc_buf = capt_buf;
-		capt_buf = tmp;
-	}
+	// Hand the full buffer to the main loop and continue in the next one. If
+	// processing has fallen behind far enough that there is no free buffer,
+	// the frame is dropped and counted, and this buffer is refilled.
+	if (buf.full()) frames.push();
 }
+#endif
 
 /*
 *	Initialize the onboard ADC.
@@ -149,18 +484,16 @@ void init_adc() {
 	
 	sbi(ADCSRA, ADEN);			// Enable the ADC
 
-	// Start the first conversion in Free Run mode. 
-	// NOTE: first converstion takes 25 cycles instead of 13.
-	sbi(ADCSRA, ADSC);
-
-	// TODO	The two above statements should most likely be moved to the end of 
-	// 		all performed initializations.
-
 	// Attach interrupt to handle completed conversion.
 	// Enable the analog comparator interrupt.
 	// sbi(ACSR, ACIE);
-	// Enable the ADC conversion complete interrupt.
+	// Enable the ADC conversion complete interrupt. When polling, the flag is
+	// still set on every conversion but no interrupt is taken.
+	#if CAPTURE_MODE == CAPTURE_ISR
 	sbi(ADCSRA, ADIE);
+	#else
+	cbi(ADCSRA, ADIE);
+	#endif
 
 	// Set the ADC mode to Free Run.
 	// The mode is controlled by ADTS[2:0] in ADCSRB with Free Run mode defined
@@ -169,19 +502,32 @@ void init_adc() {
 	cbi(ADCSRB, ADTS1);
 	cbi(ADCSRB, ADTS0);		
 
-	// Set prescalar to 32, ADC clock 500kHz, effective sampling rate ~38.5kHz, 
-	// effective resolution 8 bits.
-	// In the future this may be changed to 16, lowest prescalar for accurate 
-	// results, ADC clock 1MHz, effective sampling rate ~76.9kHz, 
+	// ADTS only selects the trigger source, conversions are retriggered only
+	// with auto triggering enabled.
+	sbi(ADCSRA, ADATE);
+
+	// Set the prescalar from ADC_PRESCALER. 16 is the lowest prescalar for
+	// accurate results, ADC clock 1MHz, effective sampling rate ~76.9kHz,
 	// effective resolution 8 bits.
-	// Relationship between prescalar values, Arduino ADC frequencies, 
-	// and effective resolution can be found in the above reference.
-	// sbi(ADCSRA, ADPS[2:0]);
-	// The prescalar is equal to the value of these 3 bits left shifted once.
-	// TODO	This is hardcoded as 32, set this based on the ADC_PRESCALAR macro.
-	sbi(ADCSRA, ADPS2);
-	cbi(ADCSRA, ADPS1);
-	sbi(ADCSRA, ADPS0);
+	// Relationship between prescalar values, Arduino ADC frequencies,
+	// and effective resolution can be found in include/AdcConfig.h.
+	// The prescalar is equal to 2 to the power of ADPS[2:0].
+	ADCSRA = (ADCSRA & ~(_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0)))
+			| adc_config::adps;
+
+	// Start the first conversion in Free Run mode, once everything above is
+	// set, so it already runs at ADC_PRESCALER.
+	// NOTE: first converstion takes 25 cycles instead of 13.
+	sbi(ADCSRA, ADSC);
+
+	// The first conversion samples ADC_PIN, select the input of the second,
+	// see the ADC_vect handler. The channel only locks one ADC clock after
+	// ADSC is set, so it is selected at least two ADC clocks later, within the
+	// 25 of the first conversion.
+	if (ADC_CHANNELS > 1) {
+		delayMicroseconds(2 * ADC_PRESCALER / (F_CPU / 1000000UL) + 1);
+		ADMUX = (ADMUX & 0xf0) | (ADC_PIN + 1);
+	}
 }
 
 /*
@@ -213,41 +559,432 @@ void init_analog() {
 	// shifted in the output register so the entire result is in ADCH. This is 
 	// done because reading ADCL locks both registers until ADCH is read.
 	// Setting ADLAR left shifts the results, clearing it right shifts them.
-	#if ADC_BITS <= 8
-	sbi(ADMUX, ADLAR);
-	#else
-	cbi(ADMUX, ADLAR);
-	#endif
+	if (adc_config::left_adjust) sbi(ADMUX, ADLAR);
+	else cbi(ADMUX, ADLAR);
 
-	// TODO	Set ADMUX to correct input pin as we should only be using a single 
-	//		analog pin.
+	// Select ADC_PIN, the first channel. With ADC_CHANNELS > 1 the ADC_vect
+	// handler moves on through the others.
 	ADMUX |= (ADC_PIN & 7);
 }
 
+// Apply the C. stage Pre to the whole captured buffer of channel ch.
+template <typename Pre>
+inline void preprocess_frame(capture_buffer_t& buf, uint8_t ch = 0) {
+	if (Pre::enabled) PROFILE_BEGIN(PROFILE_PREPROCESS);
+	Pre::template block<adc_data_t, FFT_N>(buf.data(), ch);
+	if (Pre::enabled) PROFILE_END(PROFILE_PREPROCESS);
+}
+
+/*
+*	A. and B. Capture stages, see include/Pipeline.h. Only the one selected
+*	by CAPTURE_MODE exists, since it owns ADC_vect.
+*/
+#if CAPTURE_MODE == CAPTURE_POLL
+struct capture_stage {
+	typedef adc_data_t raw_t;
+	static const bool in_place = true;
+	static const uint8_t channels = 1;
+
+	static void init() {}
+
+	template <typename Pre>
+	static capture_buffer_t& acquire() {
+		capture_poll(frame);
+		preprocess_frame<Pre>(frame);
+		return frame;
+	}
+
+	static capture_buffer_t& channel(capture_buffer_t& buf, uint8_t) {
+		return buf;
+	}
+
+	static void release() {}
+
+	static uint16_t dropped() { return 0; }
+};
+#elif CAPTURE_MODE == CAPTURE_OVERLAP
+struct capture_stage {
+	typedef adc_data_t raw_t;
+	static const bool in_place = false;
+	static const uint8_t channels = 1;
+
+	static void init() {}
+
+	/*
+	*	Wait for the next hop. Only the newest frame is processed, any hop in
+	*	between is a dropped frame. If processing fell behind by more than a
+	*	frame, the older hops are gone, so continue from the newest full one.
+	*
+	*	Only the new hops are preprocessed, so every sample is preprocessed
+	*	once even though it is part of several frames.
+	*/
+	template <typename Pre>
+	static capture_ring_t::View acquire() {
+		uint8_t hops;
+		while ((hops = ring_hops) == ring_hops_done);
+		HAL_BARRIER();
+		uint8_t pending = hops - ring_hops_done;
+		ring_dropped += pending - 1;
+		if (pending > FFT_N / CAPTURE_HOP) {
+			ring_hops_done = hops - FFT_N / CAPTURE_HOP;
+		}
+
+		if (Pre::enabled) PROFILE_BEGIN(PROFILE_PREPROCESS);
+		for (; ring_hops_done != hops; ++ring_hops_done) {
+			Pre::template block<raw_t, CAPTURE_HOP>(
+					ring.data() + ring_hop_end(ring_hops_done));
+		}
+		if (Pre::enabled) PROFILE_END(PROFILE_PREPROCESS);
+
+		return ring.view(ring_hop_end(hops), FFT_N);
+	}
+
+	static capture_ring_t::View& channel(capture_ring_t::View& view,
+			uint8_t) {
+		return view;
+	}
+
+	static void release() {}
+
+	static uint16_t dropped() { return ring_dropped; }
+};
+#elif ADC_CHANNELS > 1
+struct capture_stage {
+	typedef adc_data_t raw_t;
+	static const bool in_place = true;
+	static const uint8_t channels = ADC_CHANNELS;
+
+	static void init() {}
+
+	// Wait for the buffers of all channels to fill.
+	template <typename Pre>
+	static capture_frame_t& acquire() {
+		#if RATE_ADAPT
+		rate_wait_begin();
+		#endif
+		while (frames.empty());
+		#if RATE_ADAPT
+		rate_wait_end();
+		#endif
+		capture_frame_t& frame = frames.front();
+		for (uint8_t c = 0; c < ADC_CHANNELS; ++c) {
+			preprocess_frame<Pre>(frame.channel[c], c);
+		}
+		return frame;
+	}
+
+	static capture_buffer_t& channel(capture_frame_t& frame, uint8_t c) {
+		return frame.channel[c];
+	}
+
+	// Every channel has been taken through to the map.
+	static void release() { frames.pop(); }
+
+	static uint16_t dropped() { return frames.overruns(); }
+};
+#else
+struct capture_stage {
+	typedef adc_data_t raw_t;
+	static const bool in_place = true;
+	static const uint8_t channels = 1;
+
+	static void init() {
+		#if ADC_ISR_NAKED
+		capt_ptr = frames.back().data();
+		capt_left = (uint8_t)FFT_N;
+		#endif
+	}
+
+	// Wait for the buffer to fill.
+	template <typename Pre>
+	static capture_buffer_t& acquire() {
+		#if RATE_ADAPT
+		rate_wait_begin();
+		#endif
+		while (frames.empty());
+		#if RATE_ADAPT
+		rate_wait_end();
+		#endif
+		capture_buffer_t& buf = frames.front();
+		preprocess_frame<Pre>(buf);
+		return buf;
+	}
+
+	static capture_buffer_t& channel(capture_buffer_t& buf, uint8_t) {
+		return buf;
+	}
+
+	// The spectrum has been extracted, so the buffer is free to capture
+	// into.
+	static void release() { frames.pop(); }
+
+	static uint16_t dropped() { return frames.overruns(); }
+};
+#endif
+
+/*
+*	G. Output stages. An LED frame is due every 1 / LED_FPS s, timed by
+*	millis().
+*/
+uint16_t led_frame_ms;
+
+inline bool led_frame_due() {
+	uint16_t now = (uint16_t)millis();
+	if ((uint16_t)(now - led_frame_ms) < 1000 / LED_FPS) return false;
+	led_frame_ms = now;
+	return true;
+}
+
+// The strip is rotated in place, so the output starts at start() and wraps
+// around.
+struct ws2812_stage {
+	typedef ws2812_encoder encoder;
+
+	static void init() { ws2812_init(); }
+
+	static bool due() { return led_frame_due(); }
+
+	template <typename Strip>
+	static void show(Strip& strip) {
+		PROFILE_BEGIN(PROFILE_OUTPUT);
+		strip.swap();
+		ws2812_show(strip.front() + 3 * strip.start(),
+				Strip::pixels - strip.start());
+		ws2812_show(strip.front(), strip.start());
+		PROFILE_END(PROFILE_OUTPUT);
+	}
+};
+
+// While the last frame is still streaming, the LED frame waits and the
+// changes stay marked in the back buffer.
+struct apa102_stage {
+	typedef apa102_encoder encoder;
+
+	static void init() { apa102_init(); }
+
+	static bool due() { return !apa102_busy() && led_frame_due(); }
+
+	template <typename Strip>
+	static void show(Strip& strip) {
+		PROFILE_BEGIN(PROFILE_OUTPUT);
+		strip.swap();
+		apa102_show(strip.front(), Strip::pixels, strip.start());
+		PROFILE_END(PROFILE_OUTPUT);
+	}
+};
+
+// The LED frames still run, so they can be profiled.
+struct no_output_stage {
+	typedef ws2812_encoder encoder;
+
+	static void init() {}
+
+	static bool due() { return led_frame_due(); }
+
+	template <typename Strip>
+	static void show(Strip&) {}
+};
+
+#if PREPROCESS
+typedef preprocess_stage pre_stage_t;
+#else
+typedef no_preprocess_stage pre_stage_t;
+#endif
+
+#if MODE_SWITCH
+// Bit 0 of the mode is the LED effect, bit 1 the spectral engine, so the
+// button steps through the effects first.
+#if CAPTURE_MODE == CAPTURE_OVERLAP
+#error MODE_SWITCH includes SPECTRUM_GOERTZEL, which needs no overlap
+#endif
+typedef mode_spectral_stage<1, fft_stage, goertzel_stage> spectral_stage_t;
+typedef mode_post_stage<1, bands_stage<&EQ_PRESET>, identity_stage>
+		post_stage_t;
+typedef mode_map_stage<0, channels_map_stage<LED_COUNT, LED_SEGMENT>,
+		scroll_map_stage<LED_COUNT, LED_SEGMENT> > effect_stage_t;
+#else
+#if SPECTRUM_ENGINE == SPECTRUM_GOERTZEL
+#if CAPTURE_MODE == CAPTURE_OVERLAP
+#error SPECTRUM_GOERTZEL runs on every sample once and needs no overlap
+#endif
+typedef goertzel_stage spectral_stage_t;
+typedef identity_stage post_stage_t;
+#else
+typedef fft_stage spectral_stage_t;
+typedef bands_stage<&EQ_PRESET> post_stage_t;
+#endif
+
+#if LED_EFFECT == LED_EFFECT_SCROLL
+typedef scroll_map_stage<LED_COUNT, LED_SEGMENT> effect_stage_t;
+#else
+typedef channels_map_stage<LED_COUNT, LED_SEGMENT> effect_stage_t;
+#endif
+#endif
+
+#if TELEMETRY
+typedef telemetry_map_stage<effect_stage_t> map_stage_t;
+#else
+typedef effect_stage_t map_stage_t;
+#endif
+
+#if OUTPUT_MODE == OUTPUT_WS2812
+typedef ws2812_stage output_stage_t;
+#elif OUTPUT_MODE == OUTPUT_APA102
+typedef apa102_stage output_stage_t;
+#else
+typedef no_output_stage output_stage_t;
+#endif
+
+typedef Pipeline<capture_stage, pre_stage_t, spectral_stage_t, post_stage_t,
+		map_stage_t, output_stage_t> pipeline_t;
+
+/*
+*	SRAM used by each stage, checked against the budget of include/arena.h
+*	at compile time. Every static object of the firmware is listed, so a
+*	new one must be added here. Run tools/sram_report.py on the built
+*	firmware for the actual figures, which also cover the Arduino core.
+*/
+#if ADC_OVERSAMPLE > 1
+constexpr uint16_t sram_decimate = sizeof(capt_sum) + sizeof(capt_count);
+#else
+constexpr uint16_t sram_decimate = 0;
+#endif
+#if CAPTURE_MODE == CAPTURE_POLL
+constexpr uint16_t sram_capture = sizeof(frame) + sram_decimate;
+#elif CAPTURE_MODE == CAPTURE_OVERLAP
+constexpr uint16_t sram_capture = sizeof(ring) + sizeof(ring_hops)
+		+ sizeof(ring_hops_done) + sizeof(ring_dropped) + sram_decimate;
+#elif ADC_CHANNELS > 1
+constexpr uint16_t sram_capture = sizeof(frames) + sizeof(capt_channel)
+		+ sram_decimate;
+#elif ADC_ISR_NAKED
+constexpr uint16_t sram_capture = sizeof(frames) + sizeof(capt_ptr)
+		+ sizeof(capt_left) + sram_decimate;
+#else
+constexpr uint16_t sram_capture = sizeof(frames) + sram_decimate;
+#endif
+constexpr uint16_t sram_spectral = sizeof(arena)
+		+ arena_references * sizeof(void *) + sizeof(goertzel_blocks);
+constexpr uint16_t sram_post = sizeof(preprocess_state) + sizeof(band_levels)
+		+ sizeof(eq_offsets);
+#if FADE_PEAKS
+constexpr uint16_t sram_map = sizeof(fade_levels) + sizeof(fade_peaks)
+		+ sizeof(fade_holds) + sizeof(fade_dirty) + sizeof(color_hue_offset);
+#else
+constexpr uint16_t sram_map = sizeof(fade_levels) + sizeof(fade_dirty)
+		+ sizeof(color_hue_offset);
+#endif
+constexpr uint16_t sram_strip = sizeof(pipeline_t::strip_t);
+#if OUTPUT_MODE == OUTPUT_WS2812
+constexpr uint16_t sram_output = sizeof(led_frame_ms)
+		+ sizeof(ws2812_patterns);
+#elif OUTPUT_MODE == OUTPUT_APA102
+constexpr uint16_t sram_output = sizeof(led_frame_ms) + sizeof(apa102_state_t);
+#else
+constexpr uint16_t sram_output = sizeof(led_frame_ms);
+#endif
+#if MODE_SWITCH
+constexpr uint16_t sram_mode = sizeof(mode_current) + sizeof(mode_state_t);
+#elif TELEMETRY
+// The status message reads the mode.
+constexpr uint16_t sram_mode = sizeof(mode_current);
+#else
+constexpr uint16_t sram_mode = 0;
+#endif
+#if RATE_ADAPT
+constexpr uint16_t sram_rate = sizeof(rate_step) + sizeof(rate_state_t);
+#else
+constexpr uint16_t sram_rate = 0;
+#endif
+#if PROFILE
+constexpr uint16_t sram_profile = sizeof(profile_stats) + sizeof(profile_start)
+		+ sizeof(profile_overflows) + sizeof(profile_overhead)
+		+ sizeof(pipeline_t::profile_frames);
+#else
+constexpr uint16_t sram_profile = 0;
+#endif
+#if TELEMETRY
+constexpr uint16_t sram_telemetry = sizeof(telemetry_buffer)
+		+ sizeof(telemetry_state_t);
+#else
+constexpr uint16_t sram_telemetry = 0;
+#endif
+
+static_assert(sram_capture + sram_spectral + sram_post + sram_map
+		+ sram_strip + sram_output + sram_mode + sram_rate + sram_profile
+		+ sram_telemetry <= ARENA_BUDGET,
+		"the stages do not fit ARENA_BUDGET, use a smaller FFT_N, fewer "
+		"CAPTURE_FRAMES or a shorter strip");
+
 void setup() {
 
+	// Before anything else uses the USART or Timer1. A kernel that differs
+	// from the C reference stops here, asleep with interrupts disabled.
+	#if FFT_SELFTEST
+	if (!fft_selftest()) {
+		cli();
+		sleep_enable();
+		sleep_cpu();
+	}
+	#endif
+
 	init_analog();
-	init_adc();
 
-	capt_buf = &ping;
-	proc_buf = &pong;
+	#if MODE_SWITCH
+	mode_init();
+	mode_request(SPECTRUM_ENGINE << 1 | LED_EFFECT);
+	mode_update();
+	#endif
+
+	pipeline_t::init();
+	#if RATE_ADAPT
+	rate_restart();
+	#endif
+
+	#if PROFILE_GPIO
+	profile_gpio_init();
+	#endif
+	#if TELEMETRY
+	telemetry_init();
+	#endif
+	#if PROFILE
+	#if !TELEMETRY
+	Serial.begin(PROFILE_BAUD);
+	#endif
+	profile_init();
+	#elif MODE_SWITCH && MODE_SERIAL
+	Serial.begin(MODE_BAUD);
+	#endif
 
-	processing = false;
+	// The Arduino core has already enabled interrupts, so the ADC interrupt
+	// may run as soon as the first conversion completes. The ADC is started
+	// last, once capture_stage::init() has set up what the ISR writes to.
+	init_adc();
 
 	sei();		// Enable interrupts
 }
 
 void loop() {
-	// Wait for the buffer to fill.
-	while(!processing);
-
-	preprocess();
-
-	fft_input();
-	fft_execute();
-	fft_output();
+	// A new mode or sample rate takes effect between two frames.
+	#if MODE_SWITCH
+	mode_poll();
+	bool restart = mode_update();
+	#else
+	bool restart = false;
+	#endif
+	#if RATE_ADAPT
+	if (rate_update(capture_stage::dropped())) restart = true;
+	#endif
+	if (restart) {
+		pipeline_t::restart();
+		#if RATE_ADAPT
+		rate_restart();
+		#endif
+	}
 
-	postprocess();
+	pipeline_t::run();
 
-	
-}
\ No newline at end of file
+	#if TELEMETRY
+	telemetry_frame(capture_stage::dropped());
+	#endif
+}
@@ -0,0 +1,48 @@
+#include <avr/io.h>
+
+#include "include/ws2812.h"
+
+const uint8_t ws2812_patterns[4] = { 0x88, 0x8c, 0xc8, 0xcc };
+
+/*
+*	The transmitter is only enabled during ws2812_show(). Otherwise TXD is an
+*	ordinary output held low, so the line is low between frames whatever the
+*	USART idles at.
+*/
+void ws2812_init() {
+	PORTD &= ~_BV(PD1);
+	DDRD |= _BV(PD1) | _BV(PD4);
+
+	// The rate must be zero while the mode is changed, see the USART in SPI
+	// mode section of the datasheet.
+	UBRR0 = 0;
+	UCSR0C = _BV(UMSEL01) | _BV(UMSEL00);	// Master SPI, MSB first, mode 0.
+	UCSR0B = _BV(TXEN0);
+	UBRR0 = ws2812_ubrr;
+	UCSR0B = 0;
+}
+
+static inline void ws2812_put(uint8_t spi) {
+	while (!(UCSR0A & _BV(UDRE0)));
+	UDR0 = spi;
+}
+
+/*
+*	UDR is double buffered, so at least one byte is being shifted whenever
+*	the next one is written and the line only idles between LED bits.
+*/
+void ws2812_show(const uint8_t *grb, uint16_t n) {
+	UCSR0A = _BV(TXC0);
+	UCSR0B = _BV(TXEN0);
+
+	for (uint16_t i = 0; i < 3 * n; ++i) {
+		uint8_t b = grb[i];
+		ws2812_put(ws2812_patterns[b >> 6]);
+		ws2812_put(ws2812_patterns[(b >> 4) & 3]);
+		ws2812_put(ws2812_patterns[(b >> 2) & 3]);
+		ws2812_put(ws2812_patterns[b & 3]);
+	}
+
+	while (!(UCSR0A & _BV(TXC0)));
+	UCSR0B = 0;
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+Generate include/color_tables.h, the PROGMEM palettes and gamma curve used
+by the color mapping in src/color.cpp.
+
+	python3 tools/gen_color_tables.py > include/color_tables.h
+
+Palettes have 256 entries of three bytes in WS2812 order (G, R, B) at full
+brightness, already gamma corrected. The COLOR_PALETTE_* values must match
+include/color.h.
+"""
+
+import colorsys
+
+from gen_fft_tables import emit
+
+ENTRIES = 256
+GAMMA = 2.2
+
+
+def gamma(x):
+	return int(round(255.0 * x ** GAMMA))
+
+
+def rainbow(i):
+	return colorsys.hsv_to_rgb(i / ENTRIES, 1.0, 1.0)
+
+
+# Black through red, yellow to white over the first half, then back down
+# the same way so the palette wraps around without a jump.
+def heat(i):
+	t = 1.0 - abs(2.0 * i / ENTRIES - 1.0)
+	return (min(1.0, 3.0 * t), min(1.0, max(0.0, 3.0 * t - 1.0)),
+		min(1.0, max(0.0, 3.0 * t - 2.0)))
+
+
+def ocean(i):
+	return colorsys.hsv_to_rgb(0.45 + 0.25 * (1.0 - abs(2.0 * i / ENTRIES - 1.0)),
+		0.9, 1.0)
+
+
+PALETTES = [
+	('COLOR_PALETTE_RAINBOW', 'Hue wheel at full saturation', rainbow),
+	('COLOR_PALETTE_HEAT', 'Black body, black to white and back', heat),
+	('COLOR_PALETTE_OCEAN', 'Cyan to blue and back', ocean),
+]
+
+
+def grb(rgb):
+	r, g, b = rgb
+	return [gamma(g), gamma(r), gamma(b)]
+
+
+def main():
+	print('/*')
+	print('*\tGENERATED by tools/gen_color_tables.py, do not edit by hand.')
+	print('*/')
+	print('#ifndef COLOR_TABLES_H')
+	print('#define COLOR_TABLES_H')
+	print()
+	print('#include "include/hal.h"')
+	print()
+	print('// (i/255)^{:g} * 255.'.format(GAMMA))
+	emit('color_gamma_table', 'uint8_t', [gamma(i / 255.0) for i in range(256)], 16, 3)
+	print()
+	print('// {} G, R, B entries of the selected palette, gamma {:g}.'.format(ENTRIES, GAMMA))
+	for i, (macro, name, f) in enumerate(PALETTES):
+		print('#{} COLOR_PALETTE == {}'.format('if' if i == 0 else 'elif', macro))
+		print('// {}'.format(name))
+		emit('color_palette_table', 'uint8_t',
+			[c for k in range(ENTRIES) for c in grb(f(k))], 12, 3)
+	print('#endif')
+	print()
+	print('#endif')
+
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""
+Generate include/drc_table.h, the gain curve of the compressor in
+src/preprocess.cpp.
+
+	python3 tools/gen_drc_table.py > include/drc_table.h
+
+Entry i is the gain in Q12 for a frame envelope of i/64..(i+1)/64 of full
+scale, evaluated at the middle of the range. Below THRESHOLD_DB the gain is
+the makeup gain, above it the level is compressed by RATIO, and the makeup
+gain is chosen so that full scale stays at full scale. DRC_ENTRIES and
+DRC_GAIN_BITS must match the values in include/preprocess.h.
+"""
+
+import math
+
+from gen_fft_tables import emit
+
+DRC_ENTRIES = 64
+DRC_GAIN_BITS = 12
+THRESHOLD_DB = -24.0
+RATIO = 3.0
+
+
+def gain(level):
+	makeup_db = -THRESHOLD_DB * (1.0 - 1.0 / RATIO)
+	level_db = 20.0 * math.log10(level)
+	over_db = max(0.0, level_db - THRESHOLD_DB)
+	gain_db = makeup_db - over_db * (1.0 - 1.0 / RATIO)
+	return int(round(10.0 ** (gain_db / 20.0) * (1 << DRC_GAIN_BITS)))
+
+
+def main():
+	table = [gain((i + 0.5) / DRC_ENTRIES) for i in range(DRC_ENTRIES)]
+
+	print('/*')
+	print('*\tGENERATED by tools/gen_drc_table.py, do not edit by hand.')
+	print('*/')
+	print('#ifndef DRC_TABLE_H')
+	print('#define DRC_TABLE_H')
+	print()
+	print('#include "include/hal.h"')
+	print()
+	print('// Q{} gain for a frame envelope of i/{} of full scale, threshold {:g} dBFS,'.format(
+		DRC_GAIN_BITS, DRC_ENTRIES, THRESHOLD_DB))
+	print('// ratio {:g}:1.'.format(RATIO))
+	emit('preprocess_drc_table', 'uint16_t', table)
+	print()
+	print('#endif')
+
+
+if __name__ == '__main__':
+	main()
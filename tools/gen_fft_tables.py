@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""
+Generate include/fft_tables.h, the PROGMEM lookup tables used by the
+fixed-point FFT in src/fft.cpp.
+
+	python3 tools/gen_fft_tables.py > include/fft_tables.h
+
+FFT_TABLE_N, FFT_N_MAX, FFT_LOG2_BITS and the FFT_WINDOW_* values must
+match include/fft.h.
+"""
+
+import math
+
+FFT_TABLE_N = 512
+FFT_N_MAX = 256
+FFT_LOG2_BITS = 6
+Q15_MAX = 32767
+
+
+def q15(x):
+	return max(-Q15_MAX, min(Q15_MAX, int(round(x * 32768.0))))
+
+
+def bitrev8(i):
+	return int('{:08b}'.format(i)[::-1], 2)
+
+
+# Periodic (DFT-even) windows as cosine sums, w(x) = sum a[k] cos(2*pi*k*x).
+WINDOWS = [
+	('FFT_WINDOW_HANN', 'Hann', [0.5, -0.5]),
+	('FFT_WINDOW_HAMMING', 'Hamming', [0.54, -0.46]),
+	('FFT_WINDOW_BLACKMAN_HARRIS', '4 term Blackman-Harris',
+		[0.35875, -0.48829, 0.14128, -0.01168]),
+]
+
+
+def window(coeffs, n, size):
+	return sum(a * math.cos(2.0 * math.pi * k * n / size) for k, a in enumerate(coeffs))
+
+
+def emit(name, ctype, values, per_line=8, width=6):
+	print('const {} {}[{}] PROGMEM = {{'.format(ctype, name, len(values)))
+	for i in range(0, len(values), per_line):
+		row = ', '.join('{:{}d}'.format(v, width) for v in values[i:i + per_line])
+		print('\t{},'.format(row))
+	print('};')
+
+
+def main():
+	quarter = FFT_TABLE_N // 4
+	sine = [q15(math.sin(2.0 * math.pi * k / FFT_TABLE_N)) for k in range(quarter + 1)]
+
+	print('/*')
+	print('*\tGENERATED by tools/gen_fft_tables.py, do not edit by hand.')
+	print('*/')
+	print('#ifndef FFT_TABLES_H')
+	print('#define FFT_TABLES_H')
+	print()
+	print('#include "include/hal.h"')
+	print()
+	print('// Quarter wave of sin(2*pi*k/{}) in Q15, k = 0..{}.'.format(FFT_TABLE_N, quarter))
+	emit('fft_sin_table', 'int16_t', sine)
+	print()
+	print('// 8-bit bit reversal, right shift by (8 - log2(N)) for smaller N.')
+	emit('fft_bitrev_table', 'uint8_t', [bitrev8(i) for i in range(256)], 16, 3)
+	print()
+	print('// log2(1 + i/{}) in Q8, the fraction of a logarithm by the {} bits'.format(
+		1 << FFT_LOG2_BITS, FFT_LOG2_BITS))
+	print('// following the leading one.')
+	emit('fft_log2_table', 'uint8_t',
+		[int(math.floor(256.0 * math.log2(1.0 + i / (1 << FFT_LOG2_BITS))))
+		 for i in range(1 << FFT_LOG2_BITS)], 16, 3)
+	print()
+	print('// First half of the selected periodic window of length {} in Q15,'.format(FFT_N_MAX))
+	print('// n = 0..{}, the second half is symmetric.'.format(FFT_N_MAX // 2))
+	for i, (macro, name, coeffs) in enumerate(WINDOWS):
+		print('#{} FFT_WINDOW == {}'.format('if' if i == 0 else 'elif', macro))
+		print('// {}'.format(name))
+		emit('fft_window_table', 'int16_t',
+			[q15(window(coeffs, n, FFT_N_MAX)) for n in range(FFT_N_MAX // 2 + 1)])
+	print('#endif')
+	print()
+	print('#endif')
+
+
+if __name__ == '__main__':
+	main()
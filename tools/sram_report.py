@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""
+Report the SRAM used by each stage of a built firmware, from its symbol
+table.
+
+	python3 tools/sram_report.py firmware.elf [--budget 1664] [--nm avr-nm]
+
+Every object in .data and .bss is assigned to a stage by its name, as the
+modules prefix their globals, the rest is listed as core (the Arduino core
+and libc). The budget defaults to ARENA_BUDGET of include/arena.h, whatever
+remains of the SRAM is left for the stack.
+"""
+
+import argparse
+import subprocess
+import sys
+
+ARENA_SRAM = 2048
+ARENA_RESERVE = 384
+
+# Stage, symbol prefixes, in the order of the pipeline.
+STAGES = [
+	('capture', ['frames', 'ring', 'frame', 'capt_']),
+	('preprocess', ['preprocess_']),
+	('spectral', ['arena', 'fft_', 'goertzel_']),
+	('bands', ['band_', 'bands_', 'eq_']),
+	('map', ['fade_', 'color_']),
+	('strip', ['Pipeline<']),
+	('output', ['ws2812_', 'apa102_', 'led_frame_']),
+	('mode', ['mode_']),
+	('rate', ['rate_']),
+	('profile', ['profile_']),
+	('telemetry', ['telemetry']),
+]
+
+
+def symbols(nm, elf):
+	out = subprocess.run([nm, '-C', '-S', '-t', 'd', elf], check=True,
+		stdout=subprocess.PIPE, universal_newlines=True).stdout
+	for line in out.splitlines():
+		fields = line.split(None, 3)
+		if len(fields) < 4 or fields[2] not in 'bBdD':
+			continue
+		yield fields[3], int(fields[1])
+
+
+def stage(name):
+	# Function local statics show up as function::variable.
+	for label, prefixes in STAGES:
+		if any(name.startswith(p) for p in prefixes):
+			return label
+	return 'core'
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument('elf')
+	parser.add_argument('--budget', type=int, default=ARENA_SRAM - ARENA_RESERVE)
+	parser.add_argument('--sram', type=int, default=ARENA_SRAM)
+	parser.add_argument('--nm', default='avr-nm')
+	parser.add_argument('-v', '--verbose', action='store_true')
+	args = parser.parse_args()
+
+	usage = {}
+	for name, size in symbols(args.nm, args.elf):
+		label = stage(name)
+		usage.setdefault(label, []).append((size, name))
+
+	total = 0
+	for label in [s for s, _ in STAGES] + ['core']:
+		if label not in usage:
+			continue
+		size = sum(s for s, _ in usage[label])
+		total += size
+		print('{:<12} {:6d} B'.format(label, size))
+		if args.verbose:
+			for s, name in sorted(usage[label], reverse=True):
+				print('    {:6d}  {}'.format(s, name))
+
+	staged = total - sum(s for s, _ in usage.get('core', []))
+	print('{:<12} {:6d} B of {} budget, {} B left for the stack'.format(
+		'total', total, args.budget, args.sram - total))
+	return 0 if staged <= args.budget else 1
+
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+Decode and plot the binary telemetry of include/telemetry.h.
+
+	python3 tools/telemetry_plot.py /dev/ttyUSB0 [--baud 1000000] [--text]
+	python3 tools/telemetry_plot.py capture.bin --text
+
+The source is a serial port (needs pyserial) or a file of raw bytes, e.g.
+one recorded with --record. Messages are COBS decoded, checked against their
+CRC-8 and their sequence numbers. The channel levels are drawn as live bars
+with their peaks (needs matplotlib), status and profile messages are printed.
+With --text everything is printed instead.
+"""
+
+import argparse
+import struct
+import sys
+
+TELEMETRY_LEVELS = 1
+TELEMETRY_STATUS = 2
+TELEMETRY_PROFILE = 3
+
+# The order of profile_stage_t in include/profile.h.
+PROFILE_STAGES = [
+	'preprocess', 'fft_input', 'fft_execute', 'fft_output', 'output',
+	'goertzel', 'bands', 'fade', 'color',
+]
+
+
+def crc8(data):
+	# Polynomial 0x07, initial value 0, as _crc8_ccitt_update() of avr-libc.
+	crc = 0
+	for b in data:
+		crc ^= b
+		for _ in range(8):
+			crc = ((crc << 1) ^ 0x07 if crc & 0x80 else crc << 1) & 0xff
+	return crc
+
+
+def cobs_decode(data):
+	out = bytearray()
+	i = 0
+	while i < len(data):
+		code = data[i]
+		if code == 0 or i + code > len(data) + 1:
+			return None
+		out += data[i + 1:i + code]
+		i += code
+		if code != 0xff and i < len(data):
+			out.append(0)
+	return bytes(out)
+
+
+class Decoder:
+	def __init__(self):
+		self.pending = bytearray()
+		self.seq = None
+		self.bad = 0
+		self.missed = 0
+
+	# Yield (type, payload) for every valid message in data.
+	def feed(self, data):
+		self.pending += data
+		while True:
+			end = self.pending.find(0)
+			if end < 0:
+				return
+			frame = bytes(self.pending[:end])
+			del self.pending[:end + 1]
+			if not frame:
+				continue
+
+			msg = cobs_decode(frame)
+			if msg is None or len(msg) < 3 or crc8(msg[:-1]) != msg[-1]:
+				self.bad += 1
+				continue
+			if self.seq is not None:
+				self.missed += (msg[1] - self.seq - 1) & 0xff
+			self.seq = msg[1]
+			yield msg[0], msg[2:-1]
+
+
+def parse(kind, payload):
+	if kind == TELEMETRY_LEVELS and len(payload) >= 2:
+		first, n = payload[0], payload[1]
+		return 'levels', (first, list(payload[2:2 + n]))
+	if kind == TELEMETRY_STATUS and len(payload) == 7:
+		dropped, lost, mode, prescaler = struct.unpack('<HHBH', payload)
+		return 'status', {'dropped': dropped, 'lost': lost, 'mode': mode,
+			'prescaler': prescaler}
+	if kind == TELEMETRY_PROFILE and len(payload) == 15:
+		stage, count, lo, hi, mean = struct.unpack('<BHIII', payload)
+		name = PROFILE_STAGES[stage] if stage < len(PROFILE_STAGES) else str(stage)
+		return 'profile', {'stage': name, 'count': count, 'min': lo,
+			'max': hi, 'mean': mean}
+	return None, None
+
+
+def describe(what, value, decoder):
+	if what == 'status':
+		return ('status dropped {dropped} lost {lost} mode {mode} '
+			'prescaler {prescaler}'.format(**value)
+			+ ' bad {} missed {}'.format(decoder.bad, decoder.missed))
+	if what == 'profile':
+		return '{stage:<12} min {min} max {max} mean {mean} ({count})'.format(
+			**value)
+	first, levels = value
+	return 'levels {:3d} '.format(first) + ' '.join(
+		'{:3d}'.format(v) for v in levels)
+
+
+def open_source(args):
+	if args.source.startswith('/dev/') or args.source.upper().startswith('COM'):
+		import serial
+		port = serial.Serial(args.source, args.baud, timeout=0.05)
+		return lambda: port.read(4096)
+	f = open(args.source, 'rb')
+	return lambda: f.read(4096)
+
+
+def run_text(read, decoder, record):
+	while True:
+		data = read()
+		if record:
+			record.write(data)
+		for kind, payload in decoder.feed(data):
+			what, value = parse(kind, payload)
+			if what:
+				print(describe(what, value, decoder))
+		if not data and not getattr(read, 'live', False):
+			return
+
+
+def run_plot(read, decoder, record):
+	import matplotlib.animation as animation
+	import matplotlib.pyplot as plt
+
+	levels = [0] * 8
+	peaks = [0] * 8
+	fig, ax = plt.subplots()
+	ax.set_ylim(0, 255)
+	ax.set_xlabel('channel')
+	ax.set_ylabel('level')
+
+	def update(_):
+		data = read()
+		if record:
+			record.write(data)
+		for kind, payload in decoder.feed(data):
+			what, value = parse(kind, payload)
+			if what == 'levels':
+				first, new = value
+				if first + len(new) > len(levels):
+					grow = first + len(new) - len(levels)
+					levels.extend([0] * grow)
+					peaks.extend([0] * grow)
+				for i, v in enumerate(new):
+					levels[first + i] = v
+					peaks[first + i] = max(v, peaks[first + i])
+			elif what:
+				print(describe(what, value, decoder))
+
+		# Peaks fall like those of include/fade.h, if at the update rate.
+		for i, v in enumerate(levels):
+			peaks[i] = max(v, peaks[i] - 4)
+		ax.clear()
+		ax.set_ylim(0, 255)
+		ax.bar(range(len(levels)), levels, color='tab:blue')
+		ax.plot(range(len(peaks)), peaks, '_', color='tab:red', markersize=12)
+		ax.set_title('bad {} missed {}'.format(decoder.bad, decoder.missed))
+
+	plot = animation.FuncAnimation(fig, update, interval=50,
+		cache_frame_data=False)
+	plt.show()
+	return plot
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument('source', help='serial port or file of raw bytes')
+	parser.add_argument('--baud', type=int, default=1000000)
+	parser.add_argument('--text', action='store_true', help='print, no plot')
+	parser.add_argument('--record', help='also write the raw bytes here')
+	args = parser.parse_args()
+
+	read = open_source(args)
+	read.live = args.source.startswith('/dev/') \
+		or args.source.upper().startswith('COM')
+	record = open(args.record, 'wb') if args.record else None
+	decoder = Decoder()
+
+	try:
+		if args.text:
+			run_text(read, decoder, record)
+		else:
+			run_plot(read, decoder, record)
+	except KeyboardInterrupt:
+		pass
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main())